@@ -7,17 +7,40 @@
 #define ENC_PPR 600                  // Encoder PPR (runtime-configurable via HID)
 #define MOUSE_SENS 1                 // Mouse sensitivity multiplier (runtime-configurable via HID)
 #define ENC_DEBOUNCE false           // Encoder Debouncing (persisted; applied on next boot)
-#define SW_DEBOUNCE_TIME_US 8000     // Switch debounce delay in us
+#define SW_DEBOUNCE_TIME_US 8000     // Switch debounce delay in us (profile default)
 #define ENC_PULSE (ENC_PPR * 4)      // 4 pulses per PPR
 #define REACTIVE_TIMEOUT_MAX 1000000 // HID to reactive timeout in us
 #define WS2812B_LED_SIZE 40          // Number of WS2812B LEDs (persisted value can be saved; applied on reboot)
 #define WS2812B_LED_ZONES 2          // Number of WS2812B LED Zones (persisted value can be saved; applied on reboot)
 #define WS2812B_LEDS_PER_ZONE \
   WS2812B_LED_SIZE / WS2812B_LED_ZONES // Number of LEDs per zone
+#define WS2812B_STRIPS 1             // Strips on consecutive pins from WS2812B_GPIO, driven in parallel (leds[] split evenly)
+#define LED_OUTPUT_WS2812 0          // Single-wire 24-bit GRB (WS2812B_STRIPS may be > 1)
+#define LED_OUTPUT_SK6812_RGBW 1     // Single-wire 32-bit GRBW, white = min(r, g, b)
+#define LED_OUTPUT_APA102 2          // Clocked APA102/SK9822 on hardware SPI (LED_SPI pins)
+#define LED_OUTPUT LED_OUTPUT_WS2812 // LED strip driver
+#define LED_SPI spi1                 // SPI block for clocked strips
+#define LED_SPI_BAUD 8000000         // Clocked strip data rate in Hz
+#define WS2812B_FPS 200              // WS2812B render rate (effects are time-based)
+#define LED_CURRENT_LIMIT_MA 400     // Strip current budget; frames over it are dimmed (0 = off, runtime-configurable via HID)
+#define LED_MA_RED 16                // Per-LED current of each channel at full level
+#define LED_MA_GREEN 11
+#define LED_MA_BLUE 15
+#define LED_MA_IDLE 1                // Per-LED quiescent current
+#define RGB_TRANSITION_MS 500        // Effect switch crossfade (runtime-configurable via HID)
+#define RGB_IDLE_WAKE_US 100000      // Max render sleep while only static effects are visible
+#define RGB_OVERLAY_LAYERS 2         // Reactive overlay layers composited over the base effect
+#define RGB_VM_INSNS_PER_FRAME 16000 // Bytecode effect budget; LEDs past it stay dark that frame
+#define SETTINGS_COMMIT_DELAY_MS 1000 // Settings are written once changes stop for this long
+#define PROFILE_COUNT 4              // Stored input profiles (keymap, encoders, debounce, effect)
+#define PROFILE_CHORD ((1u << 8) | (1u << 9)) // Buttons held together to switch to the next profile
+#define PROFILE_CHORD_HOLD_MS 1000   // How long the chord must be held
+// #define LED_LAYOUT_MAP "layouts/matrix_8x5.h" // LED geometry table (default: uniform ring)
 
 #ifdef PICO_GAME_CONTROLLER_C
 
 // MODIFY KEYBINDS HERE, MAKE SURE LENGTHS MATCH SW_GPIO_SIZE
+// (SW_KEYCODE and ENC_REV are the defaults every profile starts from)
 const uint8_t SW_KEYCODE[] = {HID_KEY_D, HID_KEY_F, HID_KEY_J, HID_KEY_K,
                               HID_KEY_C, HID_KEY_M, HID_KEY_A, HID_KEY_B,
                               HID_KEY_1, HID_KEY_2};
@@ -28,6 +51,8 @@ const uint8_t LED_GPIO[] = {
 const uint8_t ENC_GPIO[] = {0}; // L_ENC(0, 1); R_ENC(2, 3)
 const bool ENC_REV[] = {false}; // Reverse Encoders
 const uint8_t WS2812B_GPIO = 28;
+const uint8_t LED_SPI_SCK_GPIO = 26; // Clocked strips only (SPI1 SCK)
+const uint8_t LED_SPI_TX_GPIO = 27;  // Clocked strips only (SPI1 TX)
 
 #endif
 
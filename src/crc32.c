@@ -0,0 +1,21 @@
+/**
+ * CRC-32 (IEEE) - shared by the settings journal and the flash uploads
+ * @author Renard
+ *
+ * Portable C (no SDK headers), so the host benches use the same code.
+ **/
+
+/**
+ * Continue a CRC-32 (IEEE) over more bytes; start from 0xFFFFFFFF and
+ * invert the result.
+ **/
+static uint32_t crc32_update(uint32_t crc, const uint8_t *p, uint32_t n)
+{
+  while (n--)
+  {
+    crc ^= *p++;
+    for (int k = 0; k < 8; k++)
+      crc = (crc >> 1) ^ (0xEDB88320u & -(crc & 1u));
+  }
+  return crc;
+}
@@ -7,6 +7,7 @@
  * and then add the #include here.
  **/
 extern uint64_t sw_timestamp[SW_GPIO_SIZE];
+extern uint32_t sw_debounce_us; // Active profile's debounce time
 
 #include "deferred.c"
 #include "eager.c"
\ No newline at end of file
@@ -10,7 +10,7 @@ uint16_t debounce_deferred()
   for (int i = SW_GPIO_SIZE - 1; i >= 0; i--)
   {
     if (!gpio_get(SW_GPIO[i]) &&
-        time_us_64() - sw_timestamp[i] >= SW_DEBOUNCE_TIME_US)
+        time_us_64() - sw_timestamp[i] >= sw_debounce_us)
     {
       translate_buttons = (translate_buttons << 1) | 1;
     }
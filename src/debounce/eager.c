@@ -9,7 +9,7 @@ uint16_t debounce_eager()
   uint16_t translate_buttons = 0;
   for (int i = SW_GPIO_SIZE - 1; i >= 0; i--)
   {
-    if (time_us_64() - sw_timestamp[i] <= SW_DEBOUNCE_TIME_US ||
+    if (time_us_64() - sw_timestamp[i] <= sw_debounce_us ||
         !gpio_get(SW_GPIO[i]))
     {
       translate_buttons = (translate_buttons << 1) | 1;
@@ -0,0 +1,49 @@
+/**
+ * Simple header file to include all LED output drivers
+ * @author Renard
+ *
+ * A driver pushes the rendered leds[] to the strip hardware. LED_OUTPUT in
+ * controller_config.h picks the driver at compile time (the wiring differs
+ * per strip type); show() applies the global brightness weight (0..256)
+ * while converting to the strip's wire format, so effects never see it.
+ *
+ * show() may be asked for a prefix only: the first len pixels of every
+ * chain (strip). Latching strips (WS2812/SK6812) keep the old color on the
+ * LEDs past the prefix, so this is a valid partial update that shortens
+ * the wire time of small changes; drivers that cannot do it send it all.
+ * show() returns when (time_us_64) the first bit of the frame left, for
+ * press-to-photon telemetry.
+ *
+ * To add a strip type, create a file with an init/show pair and a
+ * led_output_t, include it here and add it to the selection below.
+ **/
+#include "ws2812.pio.h"
+
+typedef struct
+{
+  const char *name;
+  void (*init)(void);
+  uint64_t (*show)(const RGB_t *px, uint32_t scale, uint16_t len); // WS2812B_LED_SIZE pixels, len per chain
+} led_output_t;
+
+#define WS2812_SM ENC_GPIO_SIZE                      // pio1 SM for single-wire strips
+#define LED_CHAIN_LEN (WS2812B_LED_SIZE / WS2812B_STRIPS) // Pixels per data line
+#define WS2812_RESET_US 300                          // Line idle time that latches a frame (280 us on current WS2812B)
+
+#include "ws2812.c"
+#include "ws2812_parallel.c"
+#include "apa102.c"
+
+#if LED_OUTPUT == LED_OUTPUT_APA102
+static const led_output_t *const led_output = &apa102_output;
+#elif LED_OUTPUT == LED_OUTPUT_SK6812_RGBW
+static const led_output_t *const led_output = &sk6812_rgbw_output;
+#elif WS2812B_STRIPS > 1
+static const led_output_t *const led_output = &ws2812_parallel_output;
+#else
+static const led_output_t *const led_output = &ws2812_output;
+#endif
+
+#if LED_OUTPUT != LED_OUTPUT_WS2812
+_Static_assert(WS2812B_STRIPS == 1, "WS2812B_STRIPS > 1 needs LED_OUTPUT_WS2812");
+#endif
@@ -0,0 +1,95 @@
+/**
+ * Single-wire WS2812B (24-bit GRB) and SK6812 RGBW (32-bit GRBW) drivers
+ * @author SpeedyPotato, Renard
+ *
+ * Both use the ws2812 PIO program on pio1; RGBW strips take 32 bits per
+ * pixel, with the white channel extracted as min(r, g, b).
+ *
+ * A frame is only latched after the line idles for WS2812_RESET_US, so a
+ * frame that follows closely (urgent renders) first waits out the bits
+ * still queued in the PIO FIFO plus the reset time.
+ **/
+
+#define WS2812_FIFO_PIXELS 9 // Joined 8-deep TX FIFO + OSR still shifting after the last put
+
+static absolute_time_t ws2812_latch_at; // Earliest start of the next frame
+
+/**
+ * WS2812B RGB Assignment
+ * @param pixel_grb The pixel color to set
+ **/
+static inline void put_pixel(uint32_t pixel_grb)
+{
+  pio_sm_put_blocking(pio1, WS2812_SM, pixel_grb << 8u);
+}
+
+static void ws2812_init(void)
+{
+  uint offset = pio_add_program(pio1, &ws2812_program);
+  ws2812_program_init(pio1, WS2812_SM, offset, WS2812B_GPIO, 800000, false);
+}
+
+/**
+ * Wait until the previous frame has latched; returns the start time
+ **/
+static inline uint64_t ws2812_begin(void)
+{
+  busy_wait_until(ws2812_latch_at);
+  return time_us_64();
+}
+
+/**
+ * Note when the line goes idle after the last put
+ * @param bits_per_pixel 24 (RGB) or 32 (RGBW)
+ **/
+static inline void ws2812_end(uint32_t bits_per_pixel)
+{
+  ws2812_latch_at = make_timeout_time_us(WS2812_FIFO_PIXELS * bits_per_pixel * 5 / 4 + WS2812_RESET_US);
+}
+
+static uint64_t ws2812_show(const RGB_t *px, uint32_t scale, uint16_t len)
+{
+  uint64_t start_us = ws2812_begin();
+  for (int i = 0; i < len; i++)
+  {
+    RGB_t p = {.u = rgb_px_scale(px[i].u, scale)};
+    put_pixel(urgb_u32(p.r, p.g, p.b));
+  }
+  ws2812_end(24);
+  return start_us;
+}
+
+static const led_output_t ws2812_output = {
+    .name = "WS2812",
+    .init = ws2812_init,
+    .show = ws2812_show,
+};
+
+static void sk6812_rgbw_init(void)
+{
+  uint offset = pio_add_program(pio1, &ws2812_program);
+  ws2812_program_init(pio1, WS2812_SM, offset, WS2812B_GPIO, 800000, true);
+}
+
+static uint64_t sk6812_rgbw_show(const RGB_t *px, uint32_t scale, uint16_t len)
+{
+  uint64_t start_us = ws2812_begin();
+  for (int i = 0; i < len; i++)
+  {
+    RGB_t p = {.u = rgb_px_scale(px[i].u, scale)};
+    // Move the common part onto the white die
+    uint8_t w = p.r < p.g ? p.r : p.g;
+    w = w < p.b ? w : p.b;
+    p.r -= w, p.g -= w, p.b -= w;
+    pio_sm_put_blocking(pio1, WS2812_SM,
+                        ((uint32_t)p.g << 24) | ((uint32_t)p.r << 16) | ((uint32_t)p.b << 8) | w);
+  }
+  ws2812_end(32);
+  return start_us;
+}
+
+static const led_output_t sk6812_rgbw_output = {
+    .name = "SK6812 RGBW",
+    .init = sk6812_rgbw_init,
+    .show = sk6812_rgbw_show,
+};
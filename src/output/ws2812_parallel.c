@@ -0,0 +1,126 @@
+/**
+ * Parallel WS2812B output driver - WS2812B_STRIPS strips on consecutive pins
+ * @author Renard
+ *
+ * leds[] is split into WS2812B_STRIPS equal segments, one per strip,
+ * starting at WS2812B_GPIO. The ws2812_parallel PIO program clocks out one
+ * 32-bit word per bit period, bit s driving strip s, so the frame is packed
+ * as bit planes: 24 words per LED index, MSB (green bit 7) first. Planes are
+ * built on the CPU with an 8x8 bit transpose (8 strips per pass) and fed
+ * to the SM by DMA; packing the next frame overlaps the previous transfer.
+ *
+ * Refresh time depends on the strip length only, not on the strip count.
+ * A prefix update packs and sends only the first len LEDs of every strip.
+ **/
+
+#if LED_OUTPUT == LED_OUTPUT_WS2812 && WS2812B_STRIPS > 1
+
+#define WS2812B_STRIP_LEN (WS2812B_LED_SIZE / WS2812B_STRIPS)
+#define WS2812B_PLANE_WORDS (WS2812B_STRIP_LEN * 24)
+
+_Static_assert(WS2812B_LED_SIZE % WS2812B_STRIPS == 0, "WS2812B_LED_SIZE must split evenly across WS2812B_STRIPS");
+_Static_assert(WS2812B_STRIPS <= 32, "ws2812_parallel drives at most 32 pins");
+
+static uint32_t ws_planes[2][WS2812B_PLANE_WORDS];
+static uint8_t ws_plane_back = 0;
+static int ws_dma_chan = -1;
+static absolute_time_t ws_latch_at; // Last transfer done + reset time
+
+/**
+ * Transpose an 8x8 bit matrix held as rows in two words
+ * In: hi = rows 7..4, lo = rows 3..0 (one byte each, row 7 in the top byte).
+ * Out: byte k (hi top byte = 0 .. lo bottom byte = 7) holds bit 7-k of
+ * every row, row r at bit r.
+ **/
+static inline void ws_transpose8(uint32_t *hi, uint32_t *lo)
+{
+  uint32_t x = *hi, y = *lo, t;
+  t = (x ^ (x >> 7)) & 0x00AA00AAu, x ^= t ^ (t << 7);
+  t = (y ^ (y >> 7)) & 0x00AA00AAu, y ^= t ^ (t << 7);
+  t = (x ^ (x >> 14)) & 0x0000CCCCu, x ^= t ^ (t << 14);
+  t = (y ^ (y >> 14)) & 0x0000CCCCu, y ^= t ^ (t << 14);
+  t = (x & 0xF0F0F0F0u) | ((y >> 4) & 0x0F0F0F0Fu);
+  *lo = ((x << 4) & 0xF0F0F0F0u) | (y & 0x0F0F0F0Fu);
+  *hi = t;
+}
+
+/**
+ * Load the parallel program on pio1 and claim a DMA channel feeding its FIFO
+ **/
+static void ws2812_parallel_init(void)
+{
+  PIO pio = pio1;
+  uint sm = WS2812_SM;
+  uint offset = pio_add_program(pio, &ws2812_parallel_program);
+  ws2812_parallel_program_init(pio, sm, offset, WS2812B_GPIO, WS2812B_STRIPS, 800000);
+
+  ws_dma_chan = dma_claim_unused_channel(true);
+  dma_channel_config c = dma_channel_get_default_config(ws_dma_chan);
+  channel_config_set_transfer_data_size(&c, DMA_SIZE_32);
+  channel_config_set_read_increment(&c, true);
+  channel_config_set_write_increment(&c, false);
+  channel_config_set_dreq(&c, pio_get_dreq(pio, sm, true));
+  dma_channel_configure(ws_dma_chan, &c, &pio->txf[sm], NULL, WS2812B_PLANE_WORDS, false);
+}
+
+/**
+ * Pack a frame into bit planes and start sending it
+ * @param px Frame, WS2812B_STRIPS consecutive segments of WS2812B_STRIP_LEN
+ * @param scale Output brightness weight, 0..256
+ * @param len LEDs per strip to send
+ **/
+static uint64_t ws2812_parallel_show(const RGB_t *px, uint32_t scale, uint16_t len)
+{
+  uint32_t *planes = ws_planes[ws_plane_back];
+  for (int i = 0; i < len; ++i)
+  {
+    uint32_t *w = &planes[i * 24];
+    memset(w, 0, 24 * sizeof(uint32_t));
+    for (int g = 0; g < WS2812B_STRIPS; g += 8)
+    {
+      // Wire order G, R, B; gather one channel of 8 strips per transpose
+      uint32_t hi[3] = {0}, lo[3] = {0};
+      for (int s = 0; s < 8 && g + s < WS2812B_STRIPS; ++s)
+      {
+        RGB_t p = {.u = rgb_px_scale(px[(g + s) * WS2812B_STRIP_LEN + i].u, scale)};
+        const uint8_t ch[3] = {p.g, p.r, p.b};
+        for (int c = 0; c < 3; ++c)
+        {
+          if (s < 4)
+            lo[c] |= (uint32_t)ch[c] << (8 * s);
+          else
+            hi[c] |= (uint32_t)ch[c] << (8 * (s - 4));
+        }
+      }
+      for (int c = 0; c < 3; ++c)
+      {
+        ws_transpose8(&hi[c], &lo[c]);
+        for (int k = 0; k < 4; ++k)
+        {
+          w[c * 8 + k] |= ((hi[c] >> (24 - 8 * k)) & 0xFF) << g;
+          w[c * 8 + 4 + k] |= ((lo[c] >> (24 - 8 * k)) & 0xFF) << g;
+        }
+      }
+    }
+  }
+
+  // The previous frame must have left the wire and latched before the next
+  // starts; its buffer is then free for the frame after this one
+  dma_channel_wait_for_finish_blocking(ws_dma_chan);
+  busy_wait_until(ws_latch_at);
+  uint64_t start_us = time_us_64();
+  dma_channel_set_trans_count(ws_dma_chan, (uint32_t)len * 24, false);
+  dma_channel_set_read_addr(ws_dma_chan, planes, true);
+  ws_plane_back ^= 1;
+  // One word per 1.25 us bit period, plus the PIO FIFO and reset
+  ws_latch_at = make_timeout_time_us(((uint32_t)len * 24 + 8) * 5 / 4 + WS2812_RESET_US);
+  return start_us;
+}
+
+static const led_output_t ws2812_parallel_output = {
+    .name = "WS2812 parallel",
+    .init = ws2812_parallel_init,
+    .show = ws2812_parallel_show,
+};
+
+#endif
@@ -15,6 +15,7 @@
 #include "hardware/dma.h"
 #include "hardware/irq.h"
 #include "hardware/pio.h"
+#include "hardware/spi.h"
 #include "pico/multicore.h"
 #include "pico/stdlib.h"
 #include "pico/bootrom.h"
@@ -23,13 +24,18 @@
 // Flash persistence
 #include "hardware/flash.h"
 #include "hardware/sync.h"
+#include "hardware/structs/usb.h"
 
 // RGB type definition (must be before RGB includes)
 #ifndef RGB_T_DEFINED
 #define RGB_T_DEFINED
-typedef struct
+typedef union
 {
-  uint8_t r, g, b;
+  struct
+  {
+    uint8_t r, g, b, pad;
+  };
+  uint32_t u; // Packed word for the kernels in rgb/pixel_ops.c
 } RGB_t;
 #endif
 
@@ -41,15 +47,41 @@ typedef struct
 #endif
 #define FLASH_SECTOR_SZ 4096
 #define FLASH_PAGE_SZ 256
-#define SETTINGS_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SZ) // last sector
+#define SETTINGS_JOURNAL_SECTORS 4                                         // wear-leveled settings journal
+#define SETTINGS_FLASH_SIZE (SETTINGS_JOURNAL_SECTORS * FLASH_SECTOR_SZ)
+#define SETTINGS_FLASH_OFFSET (PICO_FLASH_SIZE_BYTES - SETTINGS_FLASH_SIZE) // last sectors
+#define SETTINGS_LEGACY_OFFSET (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SZ)   // pre-journal single record
+#define RGB_VM_FLASH_SIZE FLASH_SECTOR_SZ                                  // uploaded bytecode program
+#define RGB_VM_FLASH_OFFSET (SETTINGS_FLASH_OFFSET - RGB_VM_FLASH_SIZE)
+#define RGB_CLIP_FLASH_SIZE (64 * FLASH_SECTOR_SZ)                         // uploaded animation clip
+#define RGB_CLIP_FLASH_OFFSET (RGB_VM_FLASH_OFFSET - RGB_CLIP_FLASH_SIZE)
+#define RGB_PALETTE_FLASH_SIZE FLASH_SECTOR_SZ                             // uploaded palette slots
+#define RGB_PALETTE_FLASH_OFFSET (RGB_CLIP_FLASH_OFFSET - RGB_PALETTE_FLASH_SIZE)
+#define SETTINGS_EFFECT_PARAMS_SIZE 96 // v6 parameter blocks: RGB_PARAM_EFFECTS_MAX x RGB_PARAM_COUNT
+#define PROFILE_KEYS_MAX 16 // Keymap entries stored per profile (buttons fit a uint16_t)
+#define PROFILE_DEBOUNCE_EAGER 0
+#define PROFILE_DEBOUNCE_DEFERRED 1
+
+// One input profile (v7); the active one is expanded into lookup tables by profile_apply()
+typedef struct __attribute__((packed))
+{
+  uint8_t keycode[PROFILE_KEYS_MAX]; // HID keycode per button (keyboard mode), 0 = none
+  uint16_t enc_ppr;                  // encoder PPR
+  uint8_t enc_rev;                   // bit per encoder: reverse direction
+  uint8_t mouse_sens;                // mouse sensitivity multiplier
+  uint8_t enc_debounce;              // 0/1 (applied on next init)
+  uint8_t sw_debounce;               // PROFILE_DEBOUNCE_*
+  uint8_t sw_debounce_100us;         // switch debounce time in 100 us
+  uint8_t effect_id;                 // base effect
+} profile_t;
 
 typedef struct __attribute__((packed))
 {
   uint32_t magic;      // 'CFG1'
-  uint8_t version;     // 2
+  uint8_t version;     // 7
   uint8_t effect_id;   // 0..N
   uint8_t brightness;  // 0..255
-  uint8_t reserved;    // padding
+  uint8_t transition;  // v3: effect crossfade in 10 ms units
   // v2 fields
   uint16_t enc_ppr;        // encoder PPR (x4 steps used)
   uint8_t mouse_sens;      // mouse sensitivity multiplier
@@ -57,14 +89,36 @@ typedef struct __attribute__((packed))
   uint16_t ws_led_size;    // total WS2812B LEDs (applied on reboot)
   uint8_t ws_led_zones;    // zones (applied on reboot)
   uint8_t reserved2_u8;    // padding to keep 4-byte alignment intention
+  // v4 fields: compositor overlay layers 1..N
+  uint8_t overlay_effect[RGB_OVERLAY_LAYERS];  // effect id, 0xFF = off
+  uint8_t overlay_blend[RGB_OVERLAY_LAYERS];   // RGB_BLEND_*
+  uint8_t overlay_opacity[RGB_OVERLAY_LAYERS]; // 0..255
+  // v5 fields
+  uint16_t current_limit_ma; // LED strip budget, 0 = unlimited
+  // v6 fields: per-effect tunables, see rgb/effect_params.c
+  uint8_t effect_params[SETTINGS_EFFECT_PARAMS_SIZE];
+  // v7 fields: input profiles; the v2 fields and effect_id mirror the active one
+  uint8_t active_profile;
+  uint8_t reserved3_u8;
+  profile_t profiles[PROFILE_COUNT];
 } settings_t;
 
 static const uint32_t SETTINGS_MAGIC = 0x31474643u; // 'CFG1' LE
 static void load_settings(void);
 static void save_settings(void);
+static void flash_write(uint32_t offset, const uint8_t *data, uint32_t len);
+static void flash_program(uint32_t offset, const uint8_t *data, uint32_t len);
+#define FLASH_JOBS 4 // Queued upload writes (see flash_task()); a full queue is written on the spot
+static void flash_queue(uint32_t offset, const uint8_t *data, uint32_t len, bool erase, void (*done)(void));
+static void flash_flush(void);
+static void flash_lock(void);
+static void flash_unlock(void);
 
+#include "crc32.c"
 #include "debounce/debounce_include.h"
 #include "rgb/rgb_include.h"
+#include "output/output_include.h"
+#include "settings_journal.c"
 // clang-format on
 
 PIO pio, pio_1;
@@ -74,20 +128,28 @@ int cur_enc_val[ENC_GPIO_SIZE];
 
 bool prev_sw_val[SW_GPIO_SIZE];
 uint64_t sw_timestamp[SW_GPIO_SIZE];
+uint32_t sw_debounce_us = SW_DEBOUNCE_TIME_US;
 
 bool kbm_report;
 
-uint64_t reactive_timeout_timestamp;
-
 // Runtime-configurable settings (published via Feature report)
 static uint16_t g_enc_ppr = ENC_PPR; // default from compile-time
 static uint32_t g_enc_pulse = (uint32_t)ENC_PPR * 4u;
 static uint8_t g_mouse_sens = MOUSE_SENS;
 static uint8_t g_enc_debounce = ENC_DEBOUNCE ? 1 : 0; // takes effect on next init
+static uint16_t g_transition_ms = RGB_TRANSITION_MS;  // effect switch crossfade
+static uint16_t g_current_limit_ma = LED_CURRENT_LIMIT_MA; // 0 = unlimited
+// Input profiles; the active one is expanded into the tables below on switch
+static profile_t g_profiles[PROFILE_COUNT];
+static uint8_t g_profile = 0;
+static uint8_t g_key_byte[SW_GPIO_SIZE]; // NKRO report byte per button
+static uint8_t g_key_mask[SW_GPIO_SIZE]; // Bit within it, 0 = unmapped
+static int g_enc_sign[ENC_GPIO_SIZE];    // Encoder direction: -1 normal, +1 reversed
+static uint64_t g_chord_since_us = 0;    // PROFILE_CHORD held since, 0 = not held
+static bool g_chord_fired = false;
 // Stored-only (cannot be safely applied at runtime without descriptor changes)
 // WS2812B size/zones are now compile-time only; no persistent override
 
-void (*ws2812b_mode)(uint32_t counter, bool hid_mode);
 void (*loop_mode)();
 uint16_t (*debounce_mode)();
 bool joy_mode_check = true;
@@ -96,98 +158,180 @@ static volatile bool g_request_bootsel = false;
 // For GET_FEATURE multiplexing of payloads
 static volatile uint8_t g_config_query_mode = 0; // 0=basic, 0x20=extended settings
 
-// RGB effect selection
-enum
-{
-  EFFECT_COLOR_CYCLE = 0,
-  EFFECT_TURBOCHARGER = 1,
-  EFFECT_TRAIL = 2,
-  EFFECT_DUAL_ORBIT = 3,
-  EFFECT_VELOCITY_COMET = 4,
-  EFFECT_BUTTON_RIPPLES = 5,
-  EFFECT_SPOKES = 6,
-  EFFECT_COUNTER_STRIPES = 7,
-  EFFECT_PALETTE_TINT_GRADIENT = 8,
-  EFFECT_MULTIPOINT_SNAP = 9,
-  EFFECT_CENTER_PULSE = 10,
-  EFFECT_SECTOR_EQUALIZER = 11,
-  EFFECT_RADAR_SWEEP = 12,
-};
-
-static uint8_t current_effect_id = EFFECT_COLOR_CYCLE;
+// RGB effect selection lives in the compositor layers (rgb_layers[0] = base)
 static uint8_t g_brightness = 255; // 0..255 scaling for WS2812B output
+// Pending GET_EFFECT_INFO query (see CMD 0x21)
+static uint8_t g_query_effect_id = 0;
+static uint8_t g_query_name_offset = 0;
+// Pending GET_LAYER query (see CMD 0x22)
+static uint8_t g_query_layer = 1;
+// Pending GET_EFFECT_PARAM query (see CMD 0x24; effect in g_query_effect_id)
+static uint8_t g_query_param = 0;
+// Pending GET_PROFILE query (see CMD 0x26)
+static uint8_t g_query_key_offset = 0;
+
+// Deferred flash writes: save_settings() only marks the settings dirty and
+// uploads queue their writes with flash_queue(); flash_task() does one of
+// them per pass of the main loop, never from a USB callback
+#define FLASH_TASK_IDLE 0
+#define FLASH_TASK_PARKING 1        // Waiting for core 1 to finish its frame
+#define FLASH_TASK_SOF 2            // Parked; waiting for the next USB frame
+#define FLASH_TASK_SOF_WAIT_US 2000 // Bus suspended or no SOF seen: write anyway
+
+typedef struct
+{
+  uint32_t offset;     // Flash offset
+  const uint8_t *data; // Left untouched by its owner until done runs; NULL = no write
+  uint32_t len;        // Multiple of FLASH_PAGE_SZ
+  bool erase;          // flash_write() rather than flash_program()
+  void (*done)(void);  // Called once written, or NULL
+} flash_job_t;
+
+static flash_job_t g_flash_jobs[FLASH_JOBS];
+static uint8_t g_flash_job_head = 0;
+static uint8_t g_flash_job_count = 0;
+static uint8_t g_flash_task_state = FLASH_TASK_IDLE;
+static uint32_t g_flash_sof = 0; // USB frame number when core 1 parked
+static uint64_t g_flash_parked_us = 0;
+static volatile bool g_settings_dirty = false;
+static volatile uint64_t g_settings_dirty_us = 0; // Last change
+static uint32_t g_settings_commits = 0;
+
+// Flash stall telemetry (interrupts-off time per erase/program, us); see CMD 0x25
+static uint32_t g_flash_stall_last_us = 0;
+static uint32_t g_flash_stall_max_us = 0;
+static volatile bool g_flash_stall_reset = false;
+
+_Static_assert(RGB_PARAM_EFFECTS_MAX * RGB_PARAM_COUNT == SETTINGS_EFFECT_PARAMS_SIZE, "settings_t.effect_params size");
+_Static_assert(sizeof(settings_t) <= SETTINGS_RECORD_MAX, "settings_t exceeds a journal record");
+_Static_assert(SW_GPIO_SIZE <= PROFILE_KEYS_MAX && ENC_GPIO_SIZE <= 8, "profile_t keymap/encoder fields too small");
+_Static_assert((PROFILE_CHORD >> SW_GPIO_SIZE) == 0, "PROFILE_CHORD names a missing button");
 
 static void set_effect_by_id(uint8_t id)
 {
-  // Update global pointer; core 1 will use it next frame
-  switch (id)
+  // O(1) registry lookup; unknown IDs fall back to the first effect
+  rgb_layer_select(0, id, RGB_BLEND_ADD, 255);
+}
+
+// ---- Input profiles ----
+
+/**
+ * Reset every profile to the default keymap and debounce and the current
+ * encoder/mouse values and effect (compile-time defaults, or what settings
+ * from before profiles stored)
+ **/
+static void profiles_default(void)
+{
+  for (int p = 0; p < PROFILE_COUNT; ++p)
   {
-  default:
-  case EFFECT_COLOR_CYCLE:
-    ws2812b_mode = &ws2812b_color_cycle;
-    current_effect_id = EFFECT_COLOR_CYCLE;
-    break;
-  case EFFECT_TURBOCHARGER:
-    ws2812b_mode = &turbocharger_color_cycle;
-    current_effect_id = EFFECT_TURBOCHARGER;
-    break;
-  case EFFECT_TRAIL:
-    ws2812b_mode = &ws2812b_trail;
-    current_effect_id = EFFECT_TRAIL;
-    break;
-  case EFFECT_DUAL_ORBIT:
-    ws2812b_mode = &ws_dual_orbit;
-    current_effect_id = EFFECT_DUAL_ORBIT;
-    break;
-  case EFFECT_VELOCITY_COMET:
-    ws2812b_mode = &ws_velocity_comet;
-    current_effect_id = EFFECT_VELOCITY_COMET;
-    break;
-  case EFFECT_BUTTON_RIPPLES:
-    ws2812b_mode = &ws_button_ripples;
-    current_effect_id = EFFECT_BUTTON_RIPPLES;
-    break;
-  case EFFECT_SPOKES:
-    ws2812b_mode = &ws_spokes;
-    current_effect_id = EFFECT_SPOKES;
-    break;
-  case EFFECT_COUNTER_STRIPES:
-    ws2812b_mode = &ws_counter_stripes;
-    current_effect_id = EFFECT_COUNTER_STRIPES;
-    break;
-  case EFFECT_PALETTE_TINT_GRADIENT:
-    ws2812b_mode = &ws_palette_tint_gradient;
-    current_effect_id = EFFECT_PALETTE_TINT_GRADIENT;
-    break;
-  case EFFECT_MULTIPOINT_SNAP:
-    ws2812b_mode = &ws_multipoint_snap;
-    current_effect_id = EFFECT_MULTIPOINT_SNAP;
-    break;
-  case EFFECT_CENTER_PULSE:
-    ws2812b_mode = &ws_center_pulse;
-    current_effect_id = EFFECT_CENTER_PULSE;
-    break;
-  case EFFECT_SECTOR_EQUALIZER:
-    ws2812b_mode = &ws_sector_equalizer;
-    current_effect_id = EFFECT_SECTOR_EQUALIZER;
-    break;
-  case EFFECT_RADAR_SWEEP:
-    ws2812b_mode = &ws_radar_sweep;
-    current_effect_id = EFFECT_RADAR_SWEEP;
-    break;
+    profile_t *pr = &g_profiles[p];
+    memset(pr, 0, sizeof(*pr));
+    memcpy(pr->keycode, SW_KEYCODE, SW_GPIO_SIZE);
+    for (int i = 0; i < ENC_GPIO_SIZE; ++i)
+      pr->enc_rev |= ENC_REV[i] ? 1u << i : 0;
+    pr->enc_ppr = g_enc_ppr;
+    pr->mouse_sens = g_mouse_sens;
+    pr->enc_debounce = g_enc_debounce;
+    pr->sw_debounce = PROFILE_DEBOUNCE_EAGER;
+    pr->sw_debounce_100us = SW_DEBOUNCE_TIME_US / 100;
+    pr->effect_id = rgb_layers[0].effect_id;
+  }
+}
+
+static inline profile_t *profile_active(void)
+{
+  return &g_profiles[g_profile];
+}
+
+/**
+ * Expand the active profile into the values and tables the report paths
+ * read, so a report costs the same as with compile-time constants. Out of
+ * range fields fall back to the compile-time defaults.
+ **/
+static void profile_apply(void)
+{
+  const profile_t *pr = profile_active();
+  for (int i = 0; i < SW_GPIO_SIZE; ++i)
+  {
+    uint8_t kc = pr->keycode[i];
+    g_key_byte[i] = 0;
+    g_key_mask[i] = 0;
+    if (kc >= 240 && kc <= 247) // Modifiers live in byte 0
+    {
+      g_key_mask[i] = (uint8_t)(1u << (kc % 8));
+    }
+    else if (kc && kc / 8 + 1 <= 31)
+    {
+      g_key_byte[i] = (uint8_t)(kc / 8 + 1);
+      g_key_mask[i] = (uint8_t)(1u << (kc % 8));
+    }
+  }
+  for (int i = 0; i < ENC_GPIO_SIZE; ++i)
+    g_enc_sign[i] = (pr->enc_rev >> i) & 1u ? 1 : -1;
+  g_enc_ppr = pr->enc_ppr >= 1 && pr->enc_ppr <= 4000 ? pr->enc_ppr : ENC_PPR;
+  g_enc_pulse = (uint32_t)g_enc_ppr * 4u;
+  g_mouse_sens = pr->mouse_sens >= 1 && pr->mouse_sens <= 50 ? pr->mouse_sens : MOUSE_SENS;
+  g_enc_debounce = pr->enc_debounce ? 1 : 0;
+  sw_debounce_us = pr->sw_debounce_100us * 100u;
+  debounce_mode = pr->sw_debounce == PROFILE_DEBOUNCE_DEFERRED ? &debounce_deferred : &debounce_eager;
+}
+
+/**
+ * Switch to a profile: its tables and its base effect
+ **/
+static void profile_select(uint8_t index)
+{
+  if (index >= PROFILE_COUNT)
+    return;
+  g_profile = index;
+  profile_apply();
+  set_effect_by_id(profile_active()->effect_id);
+}
+
+/**
+ * Switch to the next profile when PROFILE_CHORD is held for
+ * PROFILE_CHORD_HOLD_MS (core 0, once per main loop); once per hold
+ **/
+static void profile_chord_task(uint16_t buttons)
+{
+  if ((buttons & PROFILE_CHORD) != PROFILE_CHORD)
+  {
+    g_chord_since_us = 0;
+    g_chord_fired = false;
+    return;
+  }
+  uint64_t now = time_us_64();
+  if (!g_chord_since_us)
+    g_chord_since_us = now;
+  else if (!g_chord_fired && now - g_chord_since_us >= PROFILE_CHORD_HOLD_MS * 1000ull)
+  {
+    g_chord_fired = true;
+    profile_select((uint8_t)((g_profile + 1) % PROFILE_COUNT));
+    save_settings();
+    rgb_doorbell_ring(RGB_WAKE_UPDATE);
   }
 }
 
 // ---- Persistent settings (flash) implementation (after effect state is defined) ----
 static void load_settings(void)
 {
-  const uint8_t *flash_ptr = (const uint8_t *)(XIP_BASE + SETTINGS_FLASH_OFFSET);
-  const settings_t *s = (const settings_t *)flash_ptr;
-  if (s->magic == SETTINGS_MAGIC && (s->version == 1 || s->version == 2))
+  // Latest journal record; before the first journaled save, the single
+  // record older firmware kept at the start of the last sector
+  settings_t stored;
+  uint16_t len = sizeof(stored);
+  settings_journal_scan();
+  const uint8_t *flash_ptr = settings_journal_read(&len);
+  if (!flash_ptr)
+    flash_ptr = (const uint8_t *)(XIP_BASE + SETTINGS_LEGACY_OFFSET);
+  memset(&stored, 0xFF, sizeof(stored)); // Fields a shorter record lacks read as erased
+  memcpy(&stored, flash_ptr, len < sizeof(stored) ? len : sizeof(stored));
+  const settings_t *s = &stored;
+  rgb_params_load(NULL); // Defaults unless stored below
+  if (s->magic == SETTINGS_MAGIC && s->version >= 1 && s->version <= 7)
   {
-    if (s->effect_id <= EFFECT_RADAR_SWEEP)
+    if (s->effect_id < RGB_EFFECT_COUNT)
     {
-      current_effect_id = s->effect_id;
+      rgb_layers[0].effect_id = s->effect_id;
     }
     g_brightness = s->brightness;
     if (s->version >= 2)
@@ -203,17 +347,61 @@ static void load_settings(void)
       }
       g_enc_debounce = s->enc_debounce ? 1 : 0; // Size/zones fields ignored (compile-time only now)
     }
+    if (s->version >= 3)
+    {
+      g_transition_ms = (uint16_t)s->transition * 10u;
+    }
+    if (s->version >= 4)
+    {
+      for (int l = 0; l < RGB_OVERLAY_LAYERS; ++l)
+      {
+        rgb_layer_select(1 + l, s->overlay_effect[l], s->overlay_blend[l], s->overlay_opacity[l]);
+      }
+    }
+    if (s->version >= 5)
+    {
+      g_current_limit_ma = s->current_limit_ma;
+    }
+    if (s->version >= 6)
+    {
+      rgb_params_load(s->effect_params);
+    }
+  }
+  profiles_default();
+  if (s->magic == SETTINGS_MAGIC && s->version >= 7)
+  {
+    memcpy(g_profiles, s->profiles, sizeof(g_profiles));
+    g_profile = s->active_profile < PROFILE_COUNT ? s->active_profile : 0;
+  }
+  profile_apply();
+  if (profile_active()->effect_id < RGB_EFFECT_COUNT)
+  {
+    rgb_layers[0].effect_id = profile_active()->effect_id;
   }
 }
 
+/**
+ * Mark the settings for saving (core 0). Bursts of changes, e.g. a
+ * brightness slider, end up in a single record.
+ **/
 static void save_settings(void)
 {
+  g_settings_dirty_us = time_us_64();
+  g_settings_dirty = true;
+}
+
+/**
+ * Write the current settings to the journal now
+ **/
+static void commit_settings(void)
+{
+  g_settings_dirty = false; // Changes from here on make it dirty again
   settings_t s = {
       .magic = SETTINGS_MAGIC,
-      .version = 2,
-      .effect_id = current_effect_id,
+      .version = 7,
+      .effect_id = rgb_layers[0].effect_id,
       .brightness = g_brightness,
-      .reserved = 0,
+      .transition = (uint8_t)(g_transition_ms / 10u),
       .enc_ppr = g_enc_ppr,
       .mouse_sens = g_mouse_sens,
       .enc_debounce = g_enc_debounce,
@@ -221,63 +409,368 @@ static void save_settings(void)
       .ws_led_size = WS2812B_LED_SIZE,
       .ws_led_zones = WS2812B_LED_ZONES,
       .reserved2_u8 = 0,
+      .current_limit_ma = g_current_limit_ma,
+      .active_profile = g_profile,
+      .reserved3_u8 = 0,
   };
+  for (int l = 0; l < RGB_OVERLAY_LAYERS; ++l)
+  {
+    s.overlay_effect[l] = rgb_layers[1 + l].effect_id;
+    s.overlay_blend[l] = rgb_layers[1 + l].blend;
+    s.overlay_opacity[l] = rgb_layers[1 + l].opacity;
+  }
+  rgb_params_store(s.effect_params);
+  memcpy(s.profiles, g_profiles, sizeof(s.profiles));
+
+  settings_journal_append(&s, sizeof(s));
+  g_settings_commits++;
+}
+
+static uint8_t flash_lock_depth = 0;
+
+/**
+ * Start taking the flash from core 1 (core 0): asks it to park in RAM at
+ * the end of its frame; rgb_park_acked() tells when it has. Nests.
+ **/
+static void flash_lock_request(void)
+{
+  if (!flash_lock_depth++)
+    rgb_park_request();
+}
 
-  // Prepare a page buffer (0xFF filled)
-  uint8_t page[FLASH_PAGE_SZ];
-  for (int i = 0; i < FLASH_PAGE_SZ; ++i)
-    page[i] = 0xFF;
-  memcpy(page, &s, sizeof(s));
+/**
+ * Take the flash from core 1 (core 0), waiting for it to park unless it
+ * already has. Nests.
+ **/
+static void flash_lock(void)
+{
+  flash_lock_request();
+  while (!rgb_park_acked())
+    tight_loop_contents();
+}
 
+static void flash_unlock(void)
+{
+  if (!--flash_lock_depth)
+    rgb_park_release();
+}
+
+/**
+ * Write the oldest queued job (core 0, flash locked)
+ **/
+static void flash_job_run(void)
+{
+  flash_job_t j = g_flash_jobs[g_flash_job_head];
+  if (j.data && j.erase)
+    flash_write(j.offset, j.data, j.len);
+  else if (j.data)
+    flash_program(j.offset, j.data, j.len);
+  g_flash_job_head = (uint8_t)((g_flash_job_head + 1) % FLASH_JOBS);
+  g_flash_job_count--;
+  if (j.done)
+    j.done(); // May queue a follow-up
+}
+
+/**
+ * Write everything queued now, without waiting for a frame gap (core 0).
+ * Only for a full queue, an upload about to reuse a queued buffer, and
+ * BOOTSEL.
+ **/
+static void flash_flush(void)
+{
+  if (!g_flash_job_count)
+    return;
+  flash_lock();
+  while (g_flash_job_count)
+    flash_job_run();
+  flash_unlock();
+}
+
+/**
+ * Queue a write for flash_task(); jobs run in order
+ * @param data Must stay unchanged until done is called; NULL just calls done
+ * @param erase Erase the covering sectors first (sector-aligned offset)
+ **/
+static void flash_queue(uint32_t offset, const uint8_t *data, uint32_t len, bool erase, void (*done)(void))
+{
+  if (g_flash_job_count == FLASH_JOBS)
+    flash_flush(); // Host outpaces the main loop
+  g_flash_jobs[(g_flash_job_head + g_flash_job_count++) % FLASH_JOBS] = (flash_job_t){
+      .offset = offset,
+      .data = data,
+      .len = len,
+      .erase = erase,
+      .done = done,
+  };
+}
+
+/**
+ * Do queued upload writes and pending settings without holding up input or
+ * rendering (core 0, main loop). Uploads go first, settings once changes
+ * have been quiet for SETTINGS_COMMIT_DELAY_MS. For each write core 1 is
+ * asked to park at the end of its frame; the loop keeps running meanwhile,
+ * and the write starts right after the next USB start of frame, so a page
+ * program (the usual journal append or clip page) fits between two frames.
+ **/
+static void flash_task(void)
+{
+  bool settings_due = g_settings_dirty && time_us_64() - g_settings_dirty_us >= SETTINGS_COMMIT_DELAY_MS * 1000ull;
+  switch (g_flash_task_state)
+  {
+  case FLASH_TASK_IDLE:
+    if (!g_flash_job_count && !settings_due)
+      return;
+    flash_lock_request();
+    g_flash_task_state = FLASH_TASK_PARKING;
+    return;
+  case FLASH_TASK_PARKING:
+    if (!rgb_park_acked())
+      return;
+    g_flash_sof = usb_hw->sof_rd;
+    g_flash_parked_us = time_us_64();
+    g_flash_task_state = FLASH_TASK_SOF;
+    return;
+  default:
+    if (tud_ready() && usb_hw->sof_rd == g_flash_sof && time_us_64() - g_flash_parked_us < FLASH_TASK_SOF_WAIT_US)
+      return;
+    break;
+  }
+  if (g_flash_job_count)
+    flash_job_run();
+  else if (settings_due)
+    commit_settings(); // Nothing if a flush took the jobs and settings changed again
+  flash_unlock();
+  g_flash_task_state = FLASH_TASK_IDLE;
+}
+
+/**
+ * Record how long interrupts were off for a flash operation
+ **/
+static void flash_stall_note(uint64_t start_us)
+{
+  uint32_t us = (uint32_t)(time_us_64() - start_us);
+  if (g_flash_stall_reset)
+  {
+    g_flash_stall_max_us = 0;
+    g_flash_stall_reset = false;
+  }
+  g_flash_stall_last_us = us;
+  if (us > g_flash_stall_max_us)
+    g_flash_stall_max_us = us;
+}
+
+/**
+ * Erase the sectors covering a region and program it
+ * @param offset Sector-aligned flash offset
+ * @param len Multiple of FLASH_PAGE_SZ
+ **/
+static void flash_write(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  flash_lock();
+  uint64_t start_us = time_us_64();
   uint32_t ints = save_and_disable_interrupts();
-  flash_range_erase(SETTINGS_FLASH_OFFSET, FLASH_SECTOR_SZ);
-  flash_range_program(SETTINGS_FLASH_OFFSET, page, FLASH_PAGE_SZ);
+  flash_range_erase(offset, (len + FLASH_SECTOR_SZ - 1) / FLASH_SECTOR_SZ * FLASH_SECTOR_SZ);
+  flash_range_program(offset, data, len);
   restore_interrupts(ints);
+  flash_stall_note(start_us);
+  flash_unlock();
+}
+
+/**
+ * Program already-erased pages
+ * @param offset Page-aligned flash offset
+ * @param len Multiple of FLASH_PAGE_SZ
+ **/
+static void flash_program(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  flash_lock();
+  uint64_t start_us = time_us_64();
+  uint32_t ints = save_and_disable_interrupts();
+  flash_range_program(offset, data, len);
+  restore_interrupts(ints);
+  flash_stall_note(start_us);
+  flash_unlock();
 }
 
 // FastLED-style LED array
 RGB_t leds[WS2812B_LED_SIZE];
+// What the strip currently shows (core 1), for prefix-only updates
+static RGB_t leds_shown[WS2812B_LED_SIZE];
+static uint32_t leds_shown_scale = UINT32_MAX;
+// Channel sums of leds_shown, kept up to date from changed pixels only
+static int32_t leds_sum_r, leds_sum_g, leds_sum_b;
+static volatile bool g_current_limited = false; // Last frame was dimmed by the limiter
+
+// Press-to-photon telemetry: button change seen by core 0 -> first bit of
+// the frame showing it. Written by core 1, read word-wise by GET_LATENCY.
+typedef struct
+{
+  uint32_t last_us;
+  uint32_t avg_us; // Moving average, 1/8 weight per sample
+  uint32_t max_us;
+  uint32_t urgent; // Frames rendered out of cadence for an edge
+} rgb_latency_t;
+static volatile rgb_latency_t rgb_latency;
+static volatile bool g_latency_reset = false; // Core 0 asks core 1 to clear max
 
-// Expose button states and HID RGB colors to RGB effects (single-writer: core 0)
-volatile uint16_t g_buttons = 0;
+// HID RGB colors for RGB effects: core 1's per-frame copy of the lights
+// state; buttons and encoders arrive via the input snapshot (rgb/input_snapshot.c)
 RGB_t hid_rgb[WS2812B_LED_ZONES];
 
-union
+typedef union
 {
   struct
   {
     uint8_t buttons[LED_GPIO_SIZE];
-    RGB_t rgb[WS2812B_LED_ZONES];
+    struct
+    {
+      uint8_t r, g, b; // 3 bytes per zone on the wire (RGB_t is padded)
+    } rgb[WS2812B_LED_ZONES];
   } lights;
   uint8_t raw[LED_GPIO_SIZE + WS2812B_LED_ZONES * 3];
-} lights_report;
+} lights_report_t;
+
+// Double-buffered lights state. The HID callback (core 0) fills the back
+// slot and then flips lights_seq; readers use slot lights_seq & 1.
+typedef struct
+{
+  lights_report_t report;
+  uint64_t received_us; // Drives the reactive timeout
+} lights_state_t;
+
+static lights_state_t lights_state[2];
+static volatile uint32_t lights_seq = 0;
+
+/**
+ * Current lights state (core 0 only, where the writer runs)
+ **/
+static inline const lights_state_t *lights_front(void)
+{
+  return &lights_state[lights_seq & 1u];
+}
+
+/**
+ * Copy the HID colors from the front slot (core 1)
+ * Retries if core 0 flipped mid-copy, since its next write reuses that slot.
+ * @param out Destination colors, one per zone
+ * @return Receive time of the copied report
+ **/
+static uint64_t lights_read_rgb(RGB_t *out)
+{
+  uint32_t seq;
+  uint64_t received_us;
+  do
+  {
+    seq = lights_seq;
+    __dmb();
+    const lights_state_t *s = &lights_state[seq & 1u];
+    for (int z = 0; z < WS2812B_LED_ZONES; ++z)
+      out[z].u = rgb_pack(s->report.lights.rgb[z].r, s->report.lights.rgb[z].g, s->report.lights.rgb[z].b);
+    received_us = s->received_us;
+    __dmb();
+  } while (seq != lights_seq);
+  return received_us;
+}
+
+/**
+ * Output weight for this frame: the brightness setting, lowered if the
+ * estimated strip current would exceed the budget
+ * @param scale Requested weight, 0..256
+ **/
+static uint32_t current_limit(uint32_t scale)
+{
+  if (!g_current_limit_ma)
+    return scale;
+  // mA at full weight: channel sums are in 1/255 of a channel's full current
+  uint32_t full_ma = ((uint32_t)leds_sum_r * LED_MA_RED + (uint32_t)leds_sum_g * LED_MA_GREEN +
+                      (uint32_t)leds_sum_b * LED_MA_BLUE) / 255u;
+  const uint32_t idle_ma = WS2812B_LED_SIZE * LED_MA_IDLE;
+  uint32_t avail_ma = g_current_limit_ma > idle_ma ? g_current_limit_ma - idle_ma : 0;
+  if (full_ma * scale <= avail_ma * 256u)
+    return scale;
+  return avail_ma * 256u / full_ma;
+}
 
 /**
- * FastLED-style show function - renders the entire LED array
+ * FastLED-style show function - sends the changed part of the LED array
+ * @return Time the first bit left, 0 if nothing changed
  **/
-void show()
+uint64_t show()
 {
-  int n = WS2812B_LED_SIZE; // Always use compile-time size now
-  for (int i = 0; i < n; i++)
+  uint16_t len = 0;
+  // Shortest prefix per chain that covers every changed pixel; the current
+  // estimate follows the same changes, so unchanged pixels cost one compare
+  for (int i = 0; i < WS2812B_LED_SIZE; i++)
   {
-    // Apply global brightness scaling at output time
-    uint8_t r = (uint16_t)leds[i].r * g_brightness / 255;
-    uint8_t g = (uint16_t)leds[i].g * g_brightness / 255;
-    uint8_t b = (uint16_t)leds[i].b * g_brightness / 255;
-    put_pixel(urgb_u32(r, g, b));
+    if (((leds[i].u ^ leds_shown[i].u) & 0x00FFFFFFu) == 0)
+      continue;
+    leds_sum_r += (int32_t)leds[i].r - leds_shown[i].r;
+    leds_sum_g += (int32_t)leds[i].g - leds_shown[i].g;
+    leds_sum_b += (int32_t)leds[i].b - leds_shown[i].b;
+    leds_shown[i] = leds[i];
+    uint16_t pos = (uint16_t)(i % LED_CHAIN_LEN + 1);
+    if (pos > len)
+      len = pos;
   }
+  // Global brightness is applied by the driver while converting to wire format
+  uint32_t want = rgb_weight(g_brightness);
+  uint32_t scale = current_limit(want);
+  g_current_limited = scale < want;
+  if (scale != leds_shown_scale)
+  {
+    leds_shown_scale = scale;
+    len = LED_CHAIN_LEN;
+  }
+  if (!len)
+    return 0;
+  return led_output->show(leds, scale, len);
+}
+
+/**
+ * Record one press-to-photon sample (core 1)
+ **/
+static void rgb_latency_record(uint32_t us, bool urgent)
+{
+  if (g_latency_reset)
+  {
+    g_latency_reset = false;
+    rgb_latency.max_us = 0;
+  }
+  rgb_latency.last_us = us;
+  rgb_latency.avg_us = rgb_latency.avg_us ? rgb_latency.avg_us - rgb_latency.avg_us / 8 + us / 8 : us;
+  if (us > rgb_latency.max_us)
+    rgb_latency.max_us = us;
+  if (urgent)
+    rgb_latency.urgent++;
 }
 
 /**
  * WS2812B Lighting
- * @param counter Current number of WS2812B cycles
+ * @param time_ms Elapsed render time in ms
+ * @param dt_ms Time since the previous frame in ms
+ * @param urgent Rendered out of cadence for a button edge
  **/
-void ws2812b_update(uint32_t counter)
+void ws2812b_update(uint32_t time_ms, uint32_t dt_ms, bool urgent)
 {
-  bool hid_mode = time_us_64() - reactive_timeout_timestamp >= REACTIVE_TIMEOUT_MAX;
-  ws2812b_mode(counter, hid_mode);
-  // Render the entire LED array at once
-  show();
+  static rgb_input_reader_t input_reader;
+  rgb_custom_palettes_sync(); // Rebake uploaded palettes after a change
+  uint64_t now = time_us_64();
+  uint64_t lights_us = lights_read_rgb(hid_rgb); // Consistent colors for the whole frame
+  uint64_t keyframe_us = rgb_keyframes_apply(hid_rgb, now); // Host fades override their zones
+  if (keyframe_us > lights_us)
+    lights_us = keyframe_us;
+  rgb_frame_t frame = {
+      .time_ms = time_ms,
+      .dt_ms = dt_ms,
+      .hid_mode = rgb_hid_timed_out(now, lights_us),
+  };
+  rgb_input_read(&input_reader, &frame.input);
+  // Base effect + overlays; layer changes from core 0 are applied here
+  rgb_compositor_render(&frame, g_transition_ms);
+  // Send what changed; nothing goes out if the frame is identical
+  uint64_t first_bit_us = show();
+  if (first_bit_us && (frame.input.pressed | frame.input.released))
+    rgb_latency_record((uint32_t)(first_bit_us - frame.input.edge_us), urgent);
 }
 
 /**
@@ -285,9 +778,10 @@ void ws2812b_update(uint32_t counter)
  **/
 void update_lights()
 {
+  const lights_state_t *lights = lights_front();
   for (int i = 0; i < LED_GPIO_SIZE; i++)
   {
-    if (time_us_64() - reactive_timeout_timestamp >= REACTIVE_TIMEOUT_MAX)
+    if (time_us_64() - lights->received_us >= REACTIVE_TIMEOUT_MAX)
     {
       if (!gpio_get(SW_GPIO[i]))
       {
@@ -301,7 +795,7 @@ void update_lights()
     else
     {
       // Use HID-provided light state
-      gpio_put(LED_GPIO[i], lights_report.lights.buttons[i] ? 1 : 0);
+      gpio_put(LED_GPIO[i], lights->report.lights.buttons[i] ? 1 : 0);
     }
   }
 }
@@ -324,7 +818,7 @@ void joy_mode()
     for (int i = 0; i < ENC_GPIO_SIZE; i++)
     {
       cur_enc_val[i] +=
-          ((ENC_REV[i] ? 1 : -1) * (enc_val[i] - prev_enc_val[i]));
+          (g_enc_sign[i] * (enc_val[i] - prev_enc_val[i]));
       while (cur_enc_val[i] < 0)
         cur_enc_val[i] = (int)g_enc_pulse + cur_enc_val[i];
       if (g_enc_pulse)
@@ -358,16 +852,7 @@ void key_mode()
       {
         if ((report.buttons >> i) % 2 == 1)
         {
-          uint8_t bit = SW_KEYCODE[i] % 8;
-          uint8_t byte = (SW_KEYCODE[i] / 8) + 1;
-          if (SW_KEYCODE[i] >= 240 && SW_KEYCODE[i] <= 247)
-          {
-            nkro_report[0] |= (1 << bit);
-          }
-          else if (byte > 0 && byte <= 31)
-          {
-            nkro_report[byte] |= (1 << bit);
-          }
+          nkro_report[g_key_byte[i]] |= g_key_mask[i]; // Active profile's keymap, see profile_apply()
         }
       }
       tud_hid_n_report(0x00, REPORT_ID_KEYBOARD, &nkro_report,
@@ -380,7 +865,7 @@ void key_mode()
       int delta[ENC_GPIO_SIZE] = {0};
       for (int i = 0; i < ENC_GPIO_SIZE; i++)
       {
-        delta[i] = (enc_val[i] - prev_enc_val[i]) * (ENC_REV[i] ? 1 : -1);
+        delta[i] = (enc_val[i] - prev_enc_val[i]) * g_enc_sign[i];
         prev_enc_val[i] = enc_val[i];
       }
       tud_hid_mouse_report(REPORT_ID_MOUSE, 0x00, delta[0] * g_mouse_sens, 0, 0,
@@ -433,11 +918,40 @@ void dma_handler()
  **/
 void core1_entry()
 {
-  uint32_t counter = 0;
+  led_layout_init(); // Geometry tables used by effects
+  rgb_particles_init(); // Particle falloff kernels
+  rgb_palettes_init();  // Baked palette tables
+  const uint64_t frame_us = 1000000u / WS2812B_FPS;
+  const uint64_t start_us = time_us_64();
+  uint32_t prev_ms = 0;
+  bool urgent = false;
+  absolute_time_t next_frame = get_absolute_time();
   while (1)
   {
-    ws2812b_update(++counter);
-    sleep_ms(5);
+    // Derive dt from the truncated elapsed time so the deltas sum exactly
+    uint32_t now_ms = (uint32_t)((time_us_64() - start_us) / 1000);
+    rgb_doorbell_clear(); // Wakes rung from here on are seen by the next wait
+    ws2812b_update(now_ms, now_ms - prev_ms, urgent);
+    prev_ms = now_ms;
+
+    // Only static effects visible and no HID fade running: sleep until core 0 reports a change
+    if (rgb_compositor_static() && !rgb_kf_running)
+    {
+      urgent = rgb_doorbell_wait(RGB_IDLE_WAKE_US); // Bounded so the HID timeout still lands
+      next_frame = get_absolute_time();
+      prev_ms = (uint32_t)((time_us_64() - start_us) / 1000) - frame_us / 1000; // Resume with a nominal dt
+      continue;
+    }
+
+    // Fixed cadence; resync instead of bursting if a frame overran. A button
+    // edge renders immediately and leaves the tick schedule alone.
+    if (!urgent)
+    {
+      next_frame = delayed_by_us(next_frame, frame_us);
+      if (absolute_time_diff_us(get_absolute_time(), next_frame) <= 0)
+        next_frame = get_absolute_time();
+    }
+    urgent = rgb_doorbell_wait_until(next_frame);
   }
 }
 
@@ -464,6 +978,8 @@ void init()
     enc_val[i], prev_enc_val[i], cur_enc_val[i] = 0;
     encoders_program_init(pio, i, offset, ENC_GPIO[i], g_enc_debounce != 0);
 
+    // Encoder i uses DMA channel i; claim it so other users (LED output) get a free one
+    dma_channel_claim(i);
     dma_channel_config c = dma_channel_get_default_config(i);
     channel_config_set_read_increment(&c, false);
     channel_config_set_write_increment(&c, false);
@@ -480,13 +996,10 @@ void init()
     dma_channel_set_irq0_enabled(i, true);
   }
 
-  reactive_timeout_timestamp = time_us_64();
+  lights_state[0].received_us = time_us_64();
 
-  // Set up WS2812B
-  pio_1 = pio1;
-  uint offset2 = pio_add_program(pio_1, &ws2812_program);
-  ws2812_program_init(pio_1, ENC_GPIO_SIZE, offset2, WS2812B_GPIO, 800000,
-                      false);
+  // Set up the LED strip output
+  led_output->init(); // Driver selected by LED_OUTPUT
 
   // Setup Button GPIO
   for (int i = 0; i < SW_GPIO_SIZE; i++)
@@ -522,14 +1035,15 @@ void init()
   }
 
   // Load persisted settings (effect + brightness), allow boot override for Turbocharger
-  set_effect_by_id(current_effect_id);
+  set_effect_by_id(rgb_layers[0].effect_id);
 
-  // Debouncing Mode
-  debounce_mode = &debounce_eager;
+  // Debouncing mode comes from the active profile (profile_apply() in load_settings())
 
   // Disable RGB
   if (gpio_get(SW_GPIO[8]))
   {
+    rgb_input_publish(0, profile_active()->enc_rev, g_enc_pulse); // Seed the snapshot so core 1's first deltas are zero
+    rgb_core1_running = true; // Flash writes park it from here on
     multicore_launch_core1(core1_entry);
   }
 }
@@ -548,13 +1062,22 @@ int main(void)
     tud_task(); // tinyusb device task
     update_inputs();
     report.buttons = debounce_mode();
-    g_buttons = report.buttons; // publish to effects
+    rgb_input_publish(report.buttons, profile_active()->enc_rev, g_enc_pulse); // one consistent snapshot for core 1
+    profile_chord_task(report.buttons);
     loop_mode();
     update_lights();
+    flash_task(); // Deferred flash writes, between USB frames
 
     // Handle deferred reboot to BOOTSEL (triggered by HID Feature command)
     if (g_request_bootsel)
     {
+      flash_flush(); // Finish uploads and keep changes made just before the reboot
+      if (g_settings_dirty)
+      {
+        flash_lock();
+        commit_settings();
+        flash_unlock();
+      }
       // Small delay to allow control transfer to finish
       sleep_ms(10);
       // Jump to UF2 bootloader (BOOTSEL)
@@ -568,6 +1091,370 @@ int main(void)
   return 0;
 }
 
+// ---- Config setters shared by the 8-byte commands and TLV transactions ----
+// Each validates its input, applies it and returns whether it did; callers save.
+
+static bool config_set_effect(uint8_t id)
+{
+  set_effect_by_id(id);
+  profile_active()->effect_id = rgb_layers[0].effect_id;
+  return true;
+}
+
+static bool config_set_transition(uint16_t ms)
+{
+  g_transition_ms = ms > 2550 ? 2550 : ms;
+  return true;
+}
+
+static bool config_set_enc_ppr(uint16_t ppr)
+{
+  if (ppr < 1 || ppr > 4000)
+    return false;
+  profile_active()->enc_ppr = ppr;
+  profile_apply();
+  return true;
+}
+
+static bool config_set_mouse_sens(uint8_t sens)
+{
+  profile_active()->mouse_sens = sens < 1 ? 1 : sens > 50 ? 50 : sens;
+  profile_apply();
+  return true;
+}
+
+static bool config_set_enc_debounce(uint8_t on)
+{
+  profile_active()->enc_debounce = on ? 1 : 0;
+  profile_apply();
+  return true;
+}
+
+static bool config_set_layer(uint8_t layer, uint8_t effect_id, uint8_t blend, uint8_t opacity)
+{
+  if (layer < 1 || layer >= RGB_LAYERS)
+    return false;
+  rgb_layer_select(layer, effect_id, blend, opacity);
+  return true;
+}
+
+static bool config_set_profile_key(uint8_t button, uint8_t keycode)
+{
+  if (button >= SW_GPIO_SIZE)
+    return false;
+  profile_active()->keycode[button] = keycode;
+  profile_apply();
+  return true;
+}
+
+static bool config_set_enc_rev(uint8_t mask)
+{
+  profile_active()->enc_rev = (uint8_t)(mask & ((1u << ENC_GPIO_SIZE) - 1));
+  profile_apply();
+  return true;
+}
+
+static bool config_set_sw_debounce(uint8_t mode, uint8_t time_100us)
+{
+  if (mode > PROFILE_DEBOUNCE_DEFERRED)
+    return false;
+  profile_active()->sw_debounce = mode;
+  profile_active()->sw_debounce_100us = time_100us;
+  profile_apply();
+  return true;
+}
+
+// ---- TLV configuration transactions (REPORT_ID_TLV) ----
+// One SET_FEATURE carries a transaction: [version, txn, item...], each item
+// [op, key, len, data[len]], op 0 ending the list. Items run in order; if
+// any SET applied, the settings are saved once at the end. The reply, read
+// with GET_FEATURE on the same report ID, is [version, txn, status, count,
+// item...] with one [status, key, len, data[len]] per request item (GET
+// data, or nothing for a SET). The txn byte is echoed so the host can tell
+// its reply from a stale one; there is no query latch.
+
+#define TLV_VERSION 1
+
+#define TLV_OP_END 0
+#define TLV_OP_GET 1 // data = arguments (LAYER: layer, EFFECT_PARAMS: effect id)
+#define TLV_OP_SET 2
+
+// Keys; values little-endian
+#define TLV_KEY_EFFECT 0x01        // u8 base effect (active profile)
+#define TLV_KEY_BRIGHTNESS 0x02    // u8
+#define TLV_KEY_TRANSITION 0x03    // u16 ms
+#define TLV_KEY_CURRENT_LIMIT 0x04 // u16 mA, 0 = unlimited
+#define TLV_KEY_ENC_PPR 0x05       // u16 (active profile)
+#define TLV_KEY_MOUSE_SENS 0x06    // u8 (active profile)
+#define TLV_KEY_ENC_DEBOUNCE 0x07  // u8 0/1 (active profile, next boot)
+#define TLV_KEY_LAYER 0x08         // [layer, effect or 0xFF, blend, opacity]
+#define TLV_KEY_EFFECT_PARAM 0x09  // SET [effect, slot, value or 0xFF] or a whole block as GET returns it;
+                                   // GET [effect] -> [effect, value x RGB_PARAM_COUNT], 0xFF = no such slot
+#define TLV_KEY_PROFILE 0x0A       // u8 active profile
+#define TLV_KEY_KEYMAP 0x0B        // keycode per button, from button 0 (active profile)
+#define TLV_KEY_ENC_REV 0x0C       // u8 bit per encoder (active profile)
+#define TLV_KEY_SW_DEBOUNCE 0x0D   // [mode, time in 100 us] (active profile)
+#define TLV_KEY_DEVICE 0x40        // GET only: [version, buttons, encoders, effects, layers, profiles, params, palettes]
+#define TLV_KEY_SETTINGS 0x7F      // GET only: DEVICE and every setting above, as separate items; not custom palettes
+
+// Item status
+#define TLV_OK 0
+#define TLV_ERR_KEY 1   // Unknown op or key, or not settable
+#define TLV_ERR_VALUE 2 // Bad length or value
+#define TLV_ERR_FULL 3  // Reply has no room left
+
+// Transaction status
+#define TLV_TXN_OK 0
+#define TLV_TXN_ITEM_FAILED 1 // At least one item failed; the others applied
+#define TLV_TXN_BAD_VERSION 2 // Nothing done; reply carries the device's version
+
+static uint8_t g_tlv_reply[TLV_REPORT_SIZE];
+static uint8_t g_tlv_reply_len = 0;
+
+/**
+ * Append a reply item
+ * @return TLV_OK, or TLV_ERR_FULL if it did not fit
+ **/
+static uint8_t tlv_reply_item(uint8_t status, uint8_t key, const uint8_t *data, uint8_t len)
+{
+  if (g_tlv_reply_len + 3u + len > TLV_REPORT_SIZE)
+    return TLV_ERR_FULL;
+  uint8_t *o = &g_tlv_reply[g_tlv_reply_len];
+  o[0] = status;
+  o[1] = key;
+  o[2] = len;
+  if (len)
+    memcpy(o + 3, data, len);
+  g_tlv_reply_len = (uint8_t)(g_tlv_reply_len + 3u + len);
+  g_tlv_reply[3]++;
+  return TLV_OK;
+}
+
+/**
+ * Read a setting into v
+ * @param arg GET arguments
+ * @return Value length, or -1 for an unknown key / bad argument
+ **/
+static int tlv_get(uint8_t key, const uint8_t *arg, uint8_t arg_len, uint8_t *v)
+{
+  const profile_t *pr = profile_active();
+  switch (key)
+  {
+  case TLV_KEY_EFFECT:
+    v[0] = rgb_layers[0].effect_id;
+    return 1;
+  case TLV_KEY_BRIGHTNESS:
+    v[0] = g_brightness;
+    return 1;
+  case TLV_KEY_TRANSITION:
+    v[0] = (uint8_t)(g_transition_ms & 0xFF);
+    v[1] = (uint8_t)(g_transition_ms >> 8);
+    return 2;
+  case TLV_KEY_CURRENT_LIMIT:
+    v[0] = (uint8_t)(g_current_limit_ma & 0xFF);
+    v[1] = (uint8_t)(g_current_limit_ma >> 8);
+    return 2;
+  case TLV_KEY_ENC_PPR:
+    v[0] = (uint8_t)(g_enc_ppr & 0xFF);
+    v[1] = (uint8_t)(g_enc_ppr >> 8);
+    return 2;
+  case TLV_KEY_MOUSE_SENS:
+    v[0] = g_mouse_sens;
+    return 1;
+  case TLV_KEY_ENC_DEBOUNCE:
+    v[0] = g_enc_debounce;
+    return 1;
+  case TLV_KEY_LAYER:
+    if (arg_len < 1 || arg[0] < 1 || arg[0] >= RGB_LAYERS)
+      return -1;
+    v[0] = arg[0];
+    v[1] = rgb_layers[arg[0]].effect_id;
+    v[2] = rgb_layers[arg[0]].blend;
+    v[3] = rgb_layers[arg[0]].opacity;
+    return 4;
+  case TLV_KEY_EFFECT_PARAM:
+    if (arg_len < 1 || arg[0] >= RGB_EFFECT_COUNT)
+      return -1;
+    v[0] = arg[0];
+    for (int i = 0; i < RGB_PARAM_COUNT; ++i)
+      v[1 + i] = rgb_effects[arg[0]].params[i].type ? rgb_param_values[arg[0]][i] : RGB_PARAM_DEFAULT;
+    return 1 + RGB_PARAM_COUNT;
+  case TLV_KEY_PROFILE:
+    v[0] = g_profile;
+    return 1;
+  case TLV_KEY_KEYMAP:
+    memcpy(v, pr->keycode, SW_GPIO_SIZE);
+    return SW_GPIO_SIZE;
+  case TLV_KEY_ENC_REV:
+    v[0] = pr->enc_rev;
+    return 1;
+  case TLV_KEY_SW_DEBOUNCE:
+    v[0] = pr->sw_debounce;
+    v[1] = pr->sw_debounce_100us;
+    return 2;
+  case TLV_KEY_DEVICE:
+    v[0] = TLV_VERSION;
+    v[1] = SW_GPIO_SIZE;
+    v[2] = ENC_GPIO_SIZE;
+    v[3] = RGB_EFFECT_COUNT;
+    v[4] = RGB_LAYERS;
+    v[5] = PROFILE_COUNT;
+    v[6] = RGB_PARAM_COUNT;
+    v[7] = RGB_PALETTE_TOTAL;
+    return 8;
+  default:
+    return -1;
+  }
+}
+
+/**
+ * Apply one SET item
+ * @return TLV_OK, TLV_ERR_KEY or TLV_ERR_VALUE
+ **/
+static uint8_t tlv_set(uint8_t key, const uint8_t *d, uint8_t len)
+{
+  uint16_t u16 = len >= 2 ? (uint16_t)(d[0] | ((uint16_t)d[1] << 8)) : 0;
+  bool ok;
+  switch (key)
+  {
+  case TLV_KEY_EFFECT:
+    ok = len == 1 && config_set_effect(d[0]);
+    break;
+  case TLV_KEY_BRIGHTNESS:
+    ok = len == 1;
+    if (ok)
+      g_brightness = d[0];
+    break;
+  case TLV_KEY_TRANSITION:
+    ok = len == 2 && config_set_transition(u16);
+    break;
+  case TLV_KEY_CURRENT_LIMIT:
+    ok = len == 2;
+    if (ok)
+      g_current_limit_ma = u16;
+    break;
+  case TLV_KEY_ENC_PPR:
+    ok = len == 2 && config_set_enc_ppr(u16);
+    break;
+  case TLV_KEY_MOUSE_SENS:
+    ok = len == 1 && config_set_mouse_sens(d[0]);
+    break;
+  case TLV_KEY_ENC_DEBOUNCE:
+    ok = len == 1 && config_set_enc_debounce(d[0]);
+    break;
+  case TLV_KEY_LAYER:
+    ok = len == 4 && config_set_layer(d[0], d[1], d[2], d[3]);
+    break;
+  case TLV_KEY_EFFECT_PARAM:
+    ok = len == 3 && rgb_param_set(d[0], d[1], d[2]);
+    if (len == 1 + RGB_PARAM_COUNT)
+    {
+      // Block: slots the effect lacks come back as 0xFF and are skipped
+      ok = d[0] < RGB_EFFECT_COUNT;
+      for (uint8_t i = 0; ok && i < RGB_PARAM_COUNT; ++i)
+        if (rgb_effects[d[0]].params[i].type || d[1 + i] != RGB_PARAM_DEFAULT)
+          ok = rgb_param_set(d[0], i, d[1 + i]);
+    }
+    break;
+  case TLV_KEY_PROFILE:
+    ok = len == 1 && d[0] < PROFILE_COUNT;
+    if (ok)
+      profile_select(d[0]);
+    break;
+  case TLV_KEY_KEYMAP:
+    ok = len >= 1 && len <= SW_GPIO_SIZE;
+    for (uint8_t i = 0; ok && i < len; ++i)
+      ok = config_set_profile_key(i, d[i]);
+    break;
+  case TLV_KEY_ENC_REV:
+    ok = len == 1 && config_set_enc_rev(d[0]);
+    break;
+  case TLV_KEY_SW_DEBOUNCE:
+    ok = len == 2 && config_set_sw_debounce(d[0], d[1]);
+    break;
+  default:
+    return TLV_ERR_KEY;
+  }
+  return ok ? TLV_OK : TLV_ERR_VALUE;
+}
+
+// Keys TLV_KEY_SETTINGS expands to; layers are added per overlay and effect
+// parameters per effect that has any. Custom palettes (up to 4 x 16 stops)
+// would not fit the reply and are read back through their upload commands.
+static const uint8_t tlv_settings_keys[] = {
+    TLV_KEY_DEVICE, TLV_KEY_PROFILE, TLV_KEY_EFFECT, TLV_KEY_BRIGHTNESS, TLV_KEY_TRANSITION,
+    TLV_KEY_CURRENT_LIMIT, TLV_KEY_ENC_PPR, TLV_KEY_MOUSE_SENS, TLV_KEY_ENC_DEBOUNCE,
+    TLV_KEY_KEYMAP, TLV_KEY_ENC_REV, TLV_KEY_SW_DEBOUNCE,
+};
+
+/**
+ * Run a transaction and build its reply (SET_FEATURE on REPORT_ID_TLV)
+ **/
+static void tlv_transaction(const uint8_t *req, uint16_t len)
+{
+  uint8_t v[TLV_REPORT_SIZE];
+  memset(g_tlv_reply, 0, sizeof(g_tlv_reply));
+  g_tlv_reply[0] = TLV_VERSION;
+  g_tlv_reply[1] = len >= 2 ? req[1] : 0;
+  g_tlv_reply_len = 4;
+  if (len < 2 || req[0] != TLV_VERSION)
+  {
+    g_tlv_reply[2] = TLV_TXN_BAD_VERSION;
+    return;
+  }
+
+  bool changed = false, failed = false;
+  uint16_t at = 2;
+  while (at + 3 <= len && req[at] != TLV_OP_END)
+  {
+    uint8_t op = req[at], key = req[at + 1], n = req[at + 2];
+    const uint8_t *d = &req[at + 3];
+    if (at + 3u + n > len)
+    {
+      tlv_reply_item(TLV_ERR_VALUE, key, NULL, 0); // Item runs past the report
+      failed = true;
+      break;
+    }
+    at = (uint16_t)(at + 3u + n);
+
+    uint8_t st;
+    if (op == TLV_OP_SET)
+    {
+      st = tlv_set(key, d, n);
+      changed |= st == TLV_OK;
+      st = tlv_reply_item(st, key, NULL, 0) == TLV_OK ? st : TLV_ERR_FULL;
+    }
+    else if (op == TLV_OP_GET && key == TLV_KEY_SETTINGS)
+    {
+      st = TLV_OK;
+      for (uint32_t k = 0; k < sizeof(tlv_settings_keys) && st == TLV_OK; ++k)
+        st = tlv_reply_item(TLV_OK, tlv_settings_keys[k], v, (uint8_t)tlv_get(tlv_settings_keys[k], NULL, 0, v));
+      for (uint8_t l = 1; l < RGB_LAYERS && st == TLV_OK; ++l)
+        st = tlv_reply_item(TLV_OK, TLV_KEY_LAYER, v, (uint8_t)tlv_get(TLV_KEY_LAYER, &l, 1, v));
+      for (uint8_t e = 0; e < RGB_EFFECT_COUNT && st == TLV_OK; ++e)
+        if (rgb_effect_has_params(e))
+          st = tlv_reply_item(TLV_OK, TLV_KEY_EFFECT_PARAM, v, (uint8_t)tlv_get(TLV_KEY_EFFECT_PARAM, &e, 1, v));
+    }
+    else if (op == TLV_OP_GET)
+    {
+      int vn = tlv_get(key, d, n, v);
+      st = vn < 0 ? tlv_reply_item(TLV_ERR_KEY, key, NULL, 0) : tlv_reply_item(TLV_OK, key, v, (uint8_t)vn);
+      st = st == TLV_OK && vn < 0 ? TLV_ERR_KEY : st;
+    }
+    else
+    {
+      st = tlv_reply_item(TLV_ERR_KEY, key, NULL, 0) == TLV_OK ? TLV_ERR_KEY : TLV_ERR_FULL;
+    }
+    failed |= st != TLV_OK;
+  }
+  g_tlv_reply[2] = failed ? TLV_TXN_ITEM_FAILED : TLV_TXN_OK;
+  if (changed)
+  {
+    save_settings(); // Once per transaction
+    rgb_doorbell_ring(RGB_WAKE_UPDATE);
+  }
+}
+
 // Invoked when received GET_REPORT control request
 // Application must fill buffer report's content and return its length.
 // Return zero will cause the stack to STALL request
@@ -579,10 +1466,193 @@ uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id,
   (void)itf;
   (void)reqlen;
 
+  if (report_id == REPORT_ID_TLV && report_type == HID_REPORT_TYPE_FEATURE)
+  {
+    // Reply to the last TLV transaction
+    uint16_t n = reqlen < TLV_REPORT_SIZE ? reqlen : TLV_REPORT_SIZE;
+    memcpy(buffer, g_tlv_reply, n);
+    return n;
+  }
   if (report_id == REPORT_ID_CONFIG && report_type == HID_REPORT_TYPE_FEATURE)
   {
     // Multiplex basic vs extended payload based on last query mode
-    if (g_config_query_mode == 0x20)
+    if (g_config_query_mode == 0x31)
+    {
+      // Stream: [status, frames(lo,hi), dropped(lo,hi), need_key, 0, 0]
+      uint32_t frames = rgb_stream_seq, dropped = rgb_stream_dropped;
+      for (int i = 0; i < 8; ++i)
+        buffer[i] = 0;
+      buffer[1] = (uint8_t)(frames & 0xFF);
+      buffer[2] = (uint8_t)(frames >> 8);
+      buffer[3] = (uint8_t)(dropped & 0xFF);
+      buffer[4] = (uint8_t)(dropped >> 8);
+      buffer[5] = rgb_stream_need_key ? 1 : 0;
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x4B)
+    {
+      // Clip: [upload_state, clip_valid, frames(lo,hi), frame_ms(lo,hi), size_kb(lo,hi)]
+      const rgb_clip_header_t *h = rgb_clip_header();
+      bool valid = !rgb_clip_writing && rgb_clip_check(h);
+      uint16_t kb = valid ? (uint16_t)((h->data_len + sizeof(*h) + 1023) / 1024) : 0;
+      buffer[0] = rgb_clip_upload_state;
+      buffer[1] = valid ? 1 : 0;
+      buffer[2] = valid ? (uint8_t)(h->frames & 0xFF) : 0;
+      buffer[3] = valid ? (uint8_t)(h->frames >> 8) : 0;
+      buffer[4] = valid ? (uint8_t)(h->frame_ms & 0xFF) : 0;
+      buffer[5] = valid ? (uint8_t)(h->frame_ms >> 8) : 0;
+      buffer[6] = (uint8_t)(kb & 0xFF);
+      buffer[7] = (uint8_t)(kb >> 8);
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x4F)
+    {
+      // Palettes: [upload_state, valid slot mask, slots, first palette id, stops_max, 0, 0, 0]
+      for (int i = 0; i < 8; ++i)
+        buffer[i] = 0;
+      buffer[0] = rgb_palette_upload_state;
+      buffer[1] = rgb_custom_palettes_valid();
+      buffer[2] = RGB_CUSTOM_PALETTES;
+      buffer[3] = PALETTE_CUSTOM;
+      buffer[4] = RGB_PALETTE_STOPS_MAX;
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x43)
+    {
+      // Bytecode: [upload_state, program_valid, words(lo,hi), insns_last_frame(lo,hi), result, 0]
+      const rgb_vm_header_t *h = (const rgb_vm_header_t *)(XIP_BASE + RGB_VM_FLASH_OFFSET);
+      bool valid = rgb_vm_validate(h, RGB_VM_FLASH_SIZE);
+      uint32_t insns = rgb_vm_last_insns;
+      uint16_t n = insns > 0xFFFF ? 0xFFFF : (uint16_t)insns;
+      buffer[0] = rgb_vm_upload_state;
+      buffer[1] = valid ? 1 : 0;
+      buffer[2] = valid ? (uint8_t)(h->words & 0xFF) : 0;
+      buffer[3] = valid ? (uint8_t)(h->words >> 8) : 0;
+      buffer[4] = (uint8_t)(n & 0xFF);
+      buffer[5] = (uint8_t)(n >> 8);
+      buffer[6] = rgb_vm_last_result;
+      buffer[7] = 0;
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x24)
+    {
+      // Effect param: [status, param, type, min, max, default, value, 0]
+      uint8_t id = g_query_effect_id, p = g_query_param;
+      for (int i = 0; i < 8; ++i)
+        buffer[i] = 0;
+      buffer[1] = p;
+      if (id < RGB_EFFECT_COUNT && p < RGB_PARAM_COUNT)
+      {
+        const rgb_param_desc_t *d = &rgb_effects[id].params[p];
+        buffer[2] = d->type;
+        buffer[3] = d->min;
+        buffer[4] = d->max;
+        buffer[5] = d->def;
+        buffer[6] = d->type ? rgb_param_values[id][p] : 0;
+      }
+      else
+      {
+        buffer[0] = 0x01; // unknown effect or parameter
+      }
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x26)
+    {
+      // Profile: [active, count, enc_rev, sw_debounce, sw_debounce_100us, keycode[off..off+2]]
+      const profile_t *pr = profile_active();
+      buffer[0] = g_profile;
+      buffer[1] = PROFILE_COUNT;
+      buffer[2] = pr->enc_rev;
+      buffer[3] = pr->sw_debounce;
+      buffer[4] = pr->sw_debounce_100us;
+      for (int i = 0; i < 3; ++i)
+      {
+        int b = g_query_key_offset + i;
+        buffer[5 + i] = b < SW_GPIO_SIZE ? pr->keycode[b] : 0;
+      }
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x25)
+    {
+      // Flash: [settings dirty | queued upload writes << 1, last_us(3 bytes le), max_us(3 bytes le), settings commits & 0xFF]
+      const uint32_t v[2] = {g_flash_stall_last_us, g_flash_stall_max_us};
+      buffer[0] = (uint8_t)((g_settings_dirty ? 1 : 0) | g_flash_job_count << 1);
+      for (int i = 0; i < 2; ++i)
+      {
+        uint32_t us = v[i] > 0xFFFFFF ? 0xFFFFFF : v[i];
+        buffer[1 + 3 * i] = (uint8_t)(us & 0xFF);
+        buffer[2 + 3 * i] = (uint8_t)((us >> 8) & 0xFF);
+        buffer[3 + 3 * i] = (uint8_t)(us >> 16);
+      }
+      buffer[7] = (uint8_t)g_settings_commits;
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x23)
+    {
+      // Latency (us, saturated): [status, last_lo, last_hi, avg_lo, avg_hi, max_lo, max_hi, urgent_frames & 0xFF]
+      const uint32_t v[3] = {rgb_latency.last_us, rgb_latency.avg_us, rgb_latency.max_us};
+      buffer[0] = 0x00;
+      for (int i = 0; i < 3; ++i)
+      {
+        uint16_t us = v[i] > 0xFFFF ? 0xFFFF : (uint16_t)v[i];
+        buffer[1 + 2 * i] = (uint8_t)(us & 0xFF);
+        buffer[2 + 2 * i] = (uint8_t)(us >> 8);
+      }
+      buffer[7] = (uint8_t)rgb_latency.urgent;
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x22)
+    {
+      // Layer: [status, layer, effect_id, blend, opacity, 0, 0, 0]
+      uint8_t l = g_query_layer;
+      for (int i = 0; i < 8; ++i)
+        buffer[i] = 0;
+      buffer[1] = l;
+      if (l >= 1 && l < RGB_LAYERS)
+      {
+        buffer[2] = rgb_layers[l].effect_id;
+        buffer[3] = rgb_layers[l].blend;
+        buffer[4] = rgb_layers[l].opacity;
+      }
+      else
+      {
+        buffer[0] = 0x01; // unknown layer
+      }
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x21)
+    {
+      // Effect info: [status, effect_count, inputs, name_len, name[offset..offset+3]]
+      uint8_t id = g_query_effect_id;
+      for (int i = 0; i < 8; ++i)
+        buffer[i] = 0;
+      buffer[1] = RGB_EFFECT_COUNT;
+      if (id < RGB_EFFECT_COUNT)
+      {
+        const char *name = rgb_effects[id].name;
+        size_t len = strlen(name);
+        buffer[2] = rgb_effects[id].inputs;
+        buffer[3] = (uint8_t)len;
+        for (size_t i = 0; i < 4 && g_query_name_offset + i < len; ++i)
+          buffer[4 + i] = (uint8_t)name[g_query_name_offset + i];
+      }
+      else
+      {
+        buffer[0] = 0x01; // unknown effect
+      }
+      g_config_query_mode = 0; // reset after read
+      return 8;
+    }
+    else if (g_config_query_mode == 0x20)
     {
       // Extended: [status, enc_ppr_lo, enc_ppr_hi, mouse_sens, enc_debounce, ws_size_lo, ws_size_hi, ws_zones]
       buffer[0] = 0x00;
@@ -598,12 +1668,15 @@ uint16_t tud_hid_get_report_cb(uint8_t itf, uint8_t report_id,
     }
     else
     {
-      // Basic: [status, effect_id, brightness, ...]
+      // Basic: [status, effect_id, brightness, transition(lo,hi), current_limit(lo,hi), limited]
       buffer[0] = 0x00; // status OK
-      buffer[1] = current_effect_id;
+      buffer[1] = rgb_layers[0].effect_id;
       buffer[2] = g_brightness;
-      for (int i = 3; i < 8; ++i)
-        buffer[i] = 0;
+      buffer[3] = (uint8_t)(g_transition_ms & 0xFF);
+      buffer[4] = (uint8_t)((g_transition_ms >> 8) & 0xFF);
+      buffer[5] = (uint8_t)(g_current_limit_ma & 0xFF);
+      buffer[6] = (uint8_t)((g_current_limit_ma >> 8) & 0xFF);
+      buffer[7] = g_current_limited ? 1 : 0;
       return 8;
     }
   }
@@ -619,19 +1692,24 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
 {
   (void)itf;
   if (report_id == 2 && report_type == HID_REPORT_TYPE_OUTPUT &&
-      bufsize >= sizeof(lights_report)) // light data
+      bufsize >= sizeof(lights_report_t)) // light data
   {
-    size_t i = 0;
-    for (i; i < sizeof(lights_report); i++)
-    {
-      lights_report.raw[i] = buffer[i];
-    }
-    // Cache HID RGB colors for effects
-    for (int z = 0; z < WS2812B_LED_ZONES; ++z)
-    {
-      hid_rgb[z] = lights_report.lights.rgb[z];
-    }
-    reactive_timeout_timestamp = time_us_64();
+    // Fill the back slot, then publish it with a single index flip
+    lights_state_t *back = &lights_state[(lights_seq + 1) & 1u];
+    memcpy(back->report.raw, buffer, sizeof(back->report.raw));
+    back->received_us = time_us_64();
+    __dmb();
+    lights_seq++;
+    rgb_keyframe_cancel(); // Direct colors take over from keyframes
+    rgb_doorbell_ring(RGB_WAKE_UPDATE);
+  }
+  else if (report_id == REPORT_ID_STREAM && report_type == HID_REPORT_TYPE_OUTPUT)
+  {
+    rgb_stream_receive(buffer, bufsize); // Per-LED frame packets for the Host Stream effect
+  }
+  else if (report_id == REPORT_ID_TLV && report_type == HID_REPORT_TYPE_FEATURE)
+  {
+    tlv_transaction(buffer, bufsize); // Batched gets/sets, one save
   }
   else if (report_id == REPORT_ID_CONFIG && report_type == HID_REPORT_TYPE_FEATURE && bufsize >= 1)
   {
@@ -643,8 +1721,7 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
     case 0x01: // SET_EFFECT
       if (bufsize >= 2)
       {
-        uint8_t id = buffer[1];
-        set_effect_by_id(id);
+        config_set_effect(buffer[1]);
         save_settings();
       }
       break;
@@ -659,38 +1736,161 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
       if (bufsize >= 3)
       {
         uint16_t ppr = (uint16_t)(buffer[1] | ((uint16_t)buffer[2] << 8));
-        if (ppr >= 1 && ppr <= 4000)
-        {
-          g_enc_ppr = ppr;
-          g_enc_pulse = (uint32_t)g_enc_ppr * 4u;
+        if (config_set_enc_ppr(ppr))
           save_settings();
-        }
       }
       break;
     case 0x11: // SET_MOUSE_SENS (arg0 = 1..50)
       if (bufsize >= 2)
       {
-        uint8_t sens = buffer[1];
-        if (sens < 1)
-          sens = 1;
-        if (sens > 50)
-          sens = 50;
-        g_mouse_sens = sens;
+        config_set_mouse_sens(buffer[1]);
         save_settings();
       }
       break;
     case 0x12: // SET_ENC_DEBOUNCE (arg0 = 0/1) — applied on next init
       if (bufsize >= 2)
       {
-        g_enc_debounce = buffer[1] ? 1 : 0;
+        config_set_enc_debounce(buffer[1]);
+        save_settings();
+      }
+      break;
+    case 0x14: // SET_TRANSITION_MS (arg0..1 = uint16 le, 0..2550)
+      if (bufsize >= 3)
+      {
+        config_set_transition((uint16_t)(buffer[1] | ((uint16_t)buffer[2] << 8)));
         save_settings();
       }
       break;
+    case 0x15: // SET_LAYER (arg0 = overlay 1..N, arg1 = effect id or 0xFF off, arg2 = blend, arg3 = opacity)
+      if (bufsize >= 5 && config_set_layer(buffer[1], buffer[2], buffer[3], buffer[4]))
+        save_settings();
+      break;
+    case 0x16: // SET_CURRENT_LIMIT (arg0..1 = uint16 le mA, 0 = unlimited)
+      if (bufsize >= 3)
+      {
+        g_current_limit_ma = (uint16_t)(buffer[1] | ((uint16_t)buffer[2] << 8));
+        save_settings();
+      }
+      break;
+    case 0x17: // SET_EFFECT_PARAM (arg0 = effect id, arg1 = param slot, arg2 = value or 0xFF = default)
+      if (bufsize >= 4 && rgb_param_set(buffer[1], buffer[2], buffer[3]))
+        save_settings();
+      break;
+    case 0x18: // SET_PROFILE (arg0 = profile 0..PROFILE_COUNT-1)
+      if (bufsize >= 2 && buffer[1] < PROFILE_COUNT)
+      {
+        profile_select(buffer[1]);
+        save_settings();
+      }
+      break;
+    case 0x19: // SET_PROFILE_KEY (arg0 = button, arg1 = HID keycode, 0 = none) — active profile
+      if (bufsize >= 3 && config_set_profile_key(buffer[1], buffer[2]))
+        save_settings();
+      break;
+    case 0x1A: // SET_ENC_REV (arg0 = bit per encoder, 1 = reversed) — active profile
+      if (bufsize >= 2 && config_set_enc_rev(buffer[1]))
+        save_settings();
+      break;
+    case 0x1B: // SET_SW_DEBOUNCE (arg0 = 0 eager / 1 deferred, arg1 = time in 100 us) — active profile
+      if (bufsize >= 3 && config_set_sw_debounce(buffer[1], buffer[2]))
+        save_settings();
+      break;
+    case 0x30: // HID_KEYFRAME (arg0 = zone | ease << 4, arg1..3 = r,g,b, arg4..5 = uint16 le ms, arg6 = delay in 10 ms)
+      if (bufsize >= 8)
+        rgb_keyframe_push(buffer[1] & 0x0F, rgb_pack(buffer[2], buffer[3], buffer[4]), buffer[1] >> 4,
+                          (uint32_t)(buffer[5] | ((uint16_t)buffer[6] << 8)), buffer[7] * 10u);
+      break;
+    case 0x31: // GET_STREAM_STATUS
+      g_config_query_mode = 0x31;
+      break;
     case 0x13: // SET_WS_PARAMS deprecated: size/zones no longer configurable; ignore
       break; // No-op
     case 0x20: // GET_EXT_STATUS (prepare extended payload for next GET_FEATURE)
       g_config_query_mode = 0x20;
       break;
+    case 0x21: // GET_EFFECT_INFO (arg0 = effect id, arg1 = name offset)
+      if (bufsize >= 3)
+      {
+        g_query_effect_id = buffer[1];
+        g_query_name_offset = buffer[2];
+        g_config_query_mode = 0x21;
+      }
+      break;
+    case 0x22: // GET_LAYER (arg0 = overlay 1..N)
+      if (bufsize >= 2)
+      {
+        g_query_layer = buffer[1];
+        g_config_query_mode = 0x22;
+      }
+      break;
+    case 0x23: // GET_LATENCY (arg0 = 1 also starts a new max)
+      g_config_query_mode = 0x23;
+      if (bufsize >= 2 && buffer[1] == 1)
+        g_latency_reset = true;
+      break;
+    case 0x26: // GET_PROFILE (arg0 = first button of the keymap window)
+      g_query_key_offset = bufsize >= 2 ? buffer[1] : 0;
+      g_config_query_mode = 0x26;
+      break;
+    case 0x25: // GET_FLASH_STATUS (arg0 = 1 also starts a new max)
+      g_config_query_mode = 0x25;
+      if (bufsize >= 2 && buffer[1] == 1)
+        g_flash_stall_reset = true;
+      break;
+    case 0x24: // GET_EFFECT_PARAM (arg0 = effect id, arg1 = param slot)
+      if (bufsize >= 3)
+      {
+        g_query_effect_id = buffer[1];
+        g_query_param = buffer[2];
+        g_config_query_mode = 0x24;
+      }
+      break;
+    case 0x40: // VM_BEGIN (start a bytecode upload)
+      rgb_vm_upload_begin();
+      break;
+    case 0x41: // VM_DATA (arg0..1 = uint16 le offset, arg2..6 = up to 5 bytes)
+      if (bufsize >= 4)
+      {
+        uint16_t off = (uint16_t)(buffer[1] | ((uint16_t)buffer[2] << 8));
+        rgb_vm_upload_data(off, &buffer[3], (uint16_t)(bufsize - 3 < 5 ? bufsize - 3 : 5));
+      }
+      break;
+    case 0x42: // VM_COMMIT (validate and store the staged program)
+      rgb_vm_upload_commit();
+      break;
+    case 0x43: // GET_VM_STATUS
+      g_config_query_mode = 0x43;
+      break;
+    case 0x48: // CLIP_BEGIN (start a clip upload; playback blanks until commit)
+      rgb_clip_upload_begin();
+      break;
+    case 0x49: // CLIP_DATA (arg0..2 = uint24 le offset, arg3..6 = up to 4 bytes, in order)
+      if (bufsize >= 5)
+      {
+        uint32_t off = buffer[1] | ((uint32_t)buffer[2] << 8) | ((uint32_t)buffer[3] << 16);
+        rgb_clip_upload_data(off, &buffer[4], (uint16_t)(bufsize - 4 < 4 ? bufsize - 4 : 4));
+      }
+      break;
+    case 0x4A: // CLIP_COMMIT (flush and verify the stored clip)
+      rgb_clip_upload_commit();
+      break;
+    case 0x4B: // GET_CLIP_STATUS
+      g_config_query_mode = 0x4B;
+      break;
+    case 0x4C: // PALETTE_BEGIN (arg0 = slot, arg1 = stop count, 0 clears the slot)
+      if (bufsize >= 3)
+        rgb_palette_upload_begin(buffer[1], buffer[2]);
+      break;
+    case 0x4D: // PALETTE_STOP (arg0 = index, arg1 = position 0..255, arg2..4 = r,g,b)
+      if (bufsize >= 6)
+        rgb_palette_upload_stop(buffer[1], buffer[2], buffer[3], buffer[4], buffer[5]);
+      break;
+    case 0x4E: // PALETTE_COMMIT (check the stops and store the slot)
+      rgb_palette_upload_commit();
+      break;
+    case 0x4F: // GET_PALETTE_STATUS
+      g_config_query_mode = 0x4F;
+      break;
     case 0x03: // REBOOT_TO_BOOTSEL
       // Defer actual reboot to main loop to avoid disrupting control transfer
       g_request_bootsel = true;
@@ -698,5 +1898,6 @@ void tud_hid_set_report_cb(uint8_t itf, uint8_t report_id,
     default:
       break;
     }
+    rgb_doorbell_ring(RGB_WAKE_UPDATE); // Settings may change what an idle renderer shows
   }
 }
@@ -1,74 +1,46 @@
 /** Button-triggered ripples expanding on the ring **/
-#include <math.h>
-static inline float circ_dist(float a, float b, float m)
-{
-    float d = fabsf(a - b);
-    return d < (m - d) ? d : (m - d);
-}
+#define RIPPLE_SPEED_Q16 (65536 / 20) // Front speed, LEDs per ms (~50 LEDs per second)
+#define RIPPLE_FADE 64                 // Fade over the last 256 ms
 
-void ws_button_ripples(uint32_t counter, bool hid_mode)
+// Each ripple is two wavefronts running apart, so the pool holds half as many ripples
+typedef struct
 {
-    set_color_palette(PALETTE_OCEAN);
-    // map buttons to angles evenly
-    float m = (float)WS2812B_LED_SIZE;
+    rgb_particle_t fronts[RGB_PARTICLES_MAX];
+} button_ripples_ctx_t;
+_Static_assert(sizeof(button_ripples_ctx_t) <= RGB_EFFECT_CTX_MAX, "button_ripples_ctx_t exceeds arena slot");
 
-    static uint16_t prev_btn = 0;
-    uint16_t now = g_buttons;
-    uint16_t pressed = (~prev_btn) & now;
-    prev_btn = now;
+void ws_button_ripples(void *ctx, const rgb_frame_t *frame)
+{
+    button_ripples_ctx_t *rc = ctx;
+    rgb_particle_t *fronts = rc->fronts;
 
-    typedef struct
-    {
-        float center;
-        uint32_t born;
-        uint8_t alive;
-        uint8_t zone;
-    } ripple_t;
-#define MAX_R 6
-    static ripple_t rip[MAX_R] = {0};
+    rgb_particles_step(fronts, RGB_PARTICLES_MAX, frame->dt_ms);
 
-    // Spawn ripples on new presses
+    // Spawn ripples on new presses; fronts die where they meet, halfway round
+    uint16_t pressed = frame->input.pressed;
     for (int bi = 0; bi < SW_GPIO_SIZE; ++bi)
     {
-        if (pressed & (1u << bi))
+        if (!(pressed & (1u << bi)))
+            continue;
+        for (int dir = -1; dir <= 1; dir += 2)
         {
-            for (int k = 0; k < MAX_R; ++k)
-                if (!rip[k].alive)
-                {
-                    rip[k].alive = 1;
-                    rip[k].born = counter;
-                    rip[k].center = (bi * m) / SW_GPIO_SIZE;
-                    rip[k].zone = (bi < (SW_GPIO_SIZE / 2)) ? 0 : 1;
-                    break;
-                }
+            rgb_particle_t *p = rgb_particle_spawn(fronts, RGB_PARTICLES_MAX);
+            *p = (rgb_particle_t){.pos = rgb_led_turn(button_anchor[bi].led),
+                                  .vel = dir * rgb_leds_to_turn(RIPPLE_SPEED_Q16),
+                                  .life_ms = (uint16_t)(WS2812B_LED_SIZE * 65536 / 2 / RIPPLE_SPEED_Q16),
+                                  .level = 255,
+                                  .flags = RGB_KERNEL_SOFT,
+                                  .tag = button_anchor[bi].zone,
+                                  .fade = RIPPLE_FADE};
         }
     }
 
+    // base dim palette
     for (int i = 0; i < WS2812B_LED_SIZE; ++i)
-    {
-        // base dim palette
-        uint32_t base = color_wheel((i * 768 / WS2812B_LED_SIZE + counter / 16) % 768);
-        uint8_t r = ((base >> 8) & 0xFF) / 10;
-        uint8_t g = ((base >> 16) & 0xFF) / 10;
-        uint8_t b = (base & 0xFF) / 10;
-
-        for (int k = 0; k < MAX_R; ++k)
-            if (rip[k].alive)
-            {
-                float age = (counter - rip[k].born) * 0.25f; // expands ~4px per 5ms
-                float d = circ_dist(i, rip[k].center, m);
-                float w = expf(-fabsf(d - age) * 0.9f);
-                RGB_t c = hid_rgb[rip[k].zone];
-                float s = hid_mode ? 0.6f : 1.0f;
-                r = (uint8_t)fminf(255.0f, r + s * w * c.r);
-                g = (uint8_t)fminf(255.0f, g + s * w * c.g);
-                b = (uint8_t)fminf(255.0f, b + s * w * c.b);
-                if (age > m)
-                    rip[k].alive = 0;
-            }
+        leds[i].u = rgb_px_scale(rgb_from_urgb(background_wheel(frame, (led_layout[i].wheel + frame->time_ms / 80) % 768)), 26);
 
-        leds[i].r = r;
-        leds[i].g = g;
-        leds[i].b = b;
-    }
+    // Fronts take their zone's current HID color
+    for (int k = 0; k < RGB_PARTICLES_MAX; ++k)
+        fronts[k].color = hid_rgb[fronts[k].tag].u;
+    rgb_particles_draw(fronts, RGB_PARTICLES_MAX, leds, frame->hid_mode ? 154 : 256);
 }
@@ -0,0 +1,154 @@
+/**
+ * Bytecode effect - runs the uploaded VM program (see vm_core.c)
+ * @author Renard
+ *
+ * The program image lives in its own flash sector below the settings
+ * (RGB_VM_FLASH_OFFSET) and executes straight from XIP. Core 0 receives a
+ * new image over HID into a RAM staging buffer (VM_BEGIN/VM_DATA), checks
+ * it and writes it to flash on VM_COMMIT, then bumps rgb_vm_generation;
+ * the effect re-validates the flash copy and restarts the program when
+ * the generation changes. Without a valid program it renders black.
+ *
+ * Author programs with tools/rgbvm.py; tools/bench/rgb_vm_bench.c runs
+ * them through this interpreter on the host.
+ **/
+
+typedef struct
+{
+  rgb_vm_state_t st;
+  int32_t px[WS2812B_LED_SIZE]; // Per-LED state words (LDP/STP)
+  uint32_t generation;          // rgb_vm_generation the program was loaded at
+  bool valid;
+} bytecode_ctx_t;
+_Static_assert(sizeof(bytecode_ctx_t) <= RGB_EFFECT_CTX_MAX, "bytecode_ctx_t exceeds arena slot");
+
+// Bumped by core 0 after each program write (starts at 1 so a zeroed ctx loads)
+static volatile uint32_t rgb_vm_generation = 1;
+
+// Last frame, for GET_VM_STATUS (core 1 writes, core 0 reads)
+static volatile uint32_t rgb_vm_last_insns = 0;
+static volatile uint8_t rgb_vm_last_result = RGB_VM_OK;
+
+static uint32_t bytecode_palette(int32_t pos)
+{
+  return rgb_from_urgb(color_wheel((uint16_t)((((uint32_t)pos & 0xFFFFu) * 768u) >> 16)));
+}
+
+static inline int32_t bytecode_turns(int32_t steps, uint32_t pulse)
+{
+  return (int32_t)(((int64_t)steps * RGB_VM_ONE) / pulse);
+}
+
+void ws_bytecode(void *ctx, const rgb_frame_t *frame)
+{
+  bytecode_ctx_t *bc = ctx;
+  const rgb_vm_header_t *h = (const rgb_vm_header_t *)(XIP_BASE + RGB_VM_FLASH_OFFSET);
+  uint32_t gen = rgb_vm_generation;
+  if (bc->generation != gen)
+  {
+    memset(bc, 0, sizeof(*bc));
+    bc->generation = gen;
+    bc->valid = rgb_vm_validate(h, RGB_VM_FLASH_SIZE);
+    bc->st.rng = 0x9E3779B9u;
+  }
+  if (!bc->valid)
+  {
+    memset(leds, 0, sizeof(leds));
+    return;
+  }
+
+  const rgb_input_t *in = &frame->input;
+  rgb_vm_io_t io = {.hid = hid_rgb, .hid_zones = WS2812B_LED_ZONES, .palette = bytecode_palette};
+  io.in[RGB_VM_IN_TIME] = (int32_t)(((uint64_t)frame->time_ms << 16) / 1000);
+  io.in[RGB_VM_IN_DT] = (int32_t)(((uint64_t)frame->dt_ms << 16) / 1000);
+  io.in[RGB_VM_IN_ENC0] = bytecode_turns((int32_t)(in->enc[0] % in->enc_pulse), in->enc_pulse);
+  io.in[RGB_VM_IN_ENC1] = bytecode_turns((int32_t)(in->enc[ENC_GPIO_SIZE > 1 ? 1 : 0] % in->enc_pulse), in->enc_pulse);
+  io.in[RGB_VM_IN_DENC0] = bytecode_turns(in->enc_delta[0], in->enc_pulse);
+  io.in[RGB_VM_IN_DENC1] = bytecode_turns(in->enc_delta[ENC_GPIO_SIZE > 1 ? 1 : 0], in->enc_pulse);
+  io.in[RGB_VM_IN_BUTTONS] = (int32_t)in->buttons << 16;
+  io.in[RGB_VM_IN_PRESSED] = (int32_t)in->pressed << 16;
+  io.in[RGB_VM_IN_HID] = frame->hid_mode ? RGB_VM_ONE : 0;
+  io.in[RGB_VM_IN_OVERLAY] = frame->overlay ? RGB_VM_ONE : 0;
+  io.in[RGB_VM_IN_LEDS] = WS2812B_LED_SIZE << 16;
+
+  const uint32_t *code = (const uint32_t *)(h + 1);
+  uint32_t budget = RGB_VM_INSNS_PER_FRAME;
+  int res = rgb_vm_exec(code, 0, h->pixel_entry, &bc->st, &io, NULL, NULL, &budget);
+  for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+  {
+    uint32_t c = 0; // LEDs the program did not reach stay dark
+    if (res == RGB_VM_OK)
+    {
+      const led_layout_t *l = &led_layout[i];
+      io.in[RGB_VM_IN_LED] = i << 16;
+      io.in[RGB_VM_IN_RING] = l->angle;
+      io.in[RGB_VM_IN_X] = l->x * RGB_VM_ONE / 127;
+      io.in[RGB_VM_IN_Y] = l->y * RGB_VM_ONE / 127;
+      io.in[RGB_VM_IN_ZONE] = l->zone << 16;
+      io.in[RGB_VM_IN_BUTTON] = l->button << 16;
+      io.in[RGB_VM_IN_HELD] = (in->buttons >> l->button) & 1u ? RGB_VM_ONE : 0;
+      res = rgb_vm_exec(code, h->pixel_entry, h->words, &bc->st, &io, &bc->px[i], &c, &budget);
+    }
+    leds[i].u = c;
+  }
+  rgb_vm_last_insns = RGB_VM_INSNS_PER_FRAME - budget;
+  rgb_vm_last_result = (uint8_t)res;
+}
+
+// ---- Upload (core 0, from the HID config callback) ----
+
+#define RGB_VM_UPLOAD_IDLE 0
+#define RGB_VM_UPLOAD_RECEIVING 1
+#define RGB_VM_UPLOAD_STORED 2
+#define RGB_VM_UPLOAD_REJECTED 3
+#define RGB_VM_UPLOAD_WRITING 4 // Committed, queued for flash_task()
+
+static uint8_t rgb_vm_staging[RGB_VM_FLASH_SIZE] __attribute__((aligned(4))); // Read as rgb_vm_header_t
+static uint8_t rgb_vm_upload_state = RGB_VM_UPLOAD_IDLE;
+
+static void rgb_vm_upload_begin(void)
+{
+  flash_flush(); // The last image may still be queued from the staging buffer
+  memset(rgb_vm_staging, 0xFF, sizeof(rgb_vm_staging));
+  rgb_vm_upload_state = RGB_VM_UPLOAD_RECEIVING;
+}
+
+/**
+ * Copy a chunk into the staging buffer; bytes past its end are dropped and
+ * a chunk starting past it rejects the upload
+ **/
+static void rgb_vm_upload_data(uint16_t offset, const uint8_t *data, uint16_t len)
+{
+  if (rgb_vm_upload_state != RGB_VM_UPLOAD_RECEIVING)
+    return;
+  if (offset >= sizeof(rgb_vm_staging))
+  {
+    rgb_vm_upload_state = RGB_VM_UPLOAD_REJECTED;
+    return;
+  }
+  if (len > sizeof(rgb_vm_staging) - offset)
+    len = (uint16_t)(sizeof(rgb_vm_staging) - offset);
+  memcpy(&rgb_vm_staging[offset], data, len);
+}
+
+static void rgb_vm_upload_stored(void)
+{
+  rgb_vm_generation++;
+  rgb_vm_upload_state = RGB_VM_UPLOAD_STORED;
+}
+
+/**
+ * Validate the staged image and queue it for flash; the effect picks it up
+ * the frame after it is written
+ **/
+static void rgb_vm_upload_commit(void)
+{
+  if (rgb_vm_upload_state != RGB_VM_UPLOAD_RECEIVING ||
+      !rgb_vm_validate((const rgb_vm_header_t *)rgb_vm_staging, sizeof(rgb_vm_staging)))
+  {
+    rgb_vm_upload_state = RGB_VM_UPLOAD_REJECTED;
+    return;
+  }
+  rgb_vm_upload_state = RGB_VM_UPLOAD_WRITING;
+  flash_queue(RGB_VM_FLASH_OFFSET, rgb_vm_staging, sizeof(rgb_vm_staging), true, rgb_vm_upload_stored);
+}
@@ -0,0 +1,238 @@
+/**
+ * Clip player - pre-rendered animation streamed from flash
+ * @author Renard
+ *
+ * A clip is authored on the host (tools/clip_pack.py), uploaded over HID
+ * into the clip partition below the bytecode sector (RGB_CLIP_FLASH_OFFSET)
+ * and decoded one frame at a time straight from XIP into the effect's own
+ * frame buffer; no frame is ever held in RAM beyond the one on screen.
+ *
+ * Image: rgb_clip_header_t, then the frames back to back. Frame 0 is a
+ * keyframe decoded over black; every later frame is a delta over the one
+ * before it, in delta_codec.c tokens covering exactly `leds` pixels. A
+ * damaged image stops playback instead of reading outside the partition.
+ **/
+
+#define RGB_CLIP_MAGIC 0x31504C43u // 'CLP1' LE
+#define RGB_CLIP_LOOP 0x0001
+
+typedef struct
+{
+  uint32_t magic;    // RGB_CLIP_MAGIC
+  uint16_t leds;     // Must match WS2812B_LED_SIZE
+  uint16_t frames;
+  uint16_t frame_ms; // Display time per frame
+  uint16_t flags;    // RGB_CLIP_*
+  uint32_t data_len; // Bytes of frame data after the header
+  uint32_t crc32;    // Over the frame data
+  char name[16];     // NUL-padded
+} rgb_clip_header_t;
+
+typedef struct
+{
+  RGB_t frame[WS2812B_LED_SIZE]; // Decoded current frame
+  uint32_t pos;                  // Byte offset of the next frame in the data
+  uint16_t index;                // Frames decoded so far
+  uint32_t elapsed_ms;           // Time shown of the current frame
+  uint32_t generation;           // rgb_clip_generation at load
+  bool valid;
+} clip_ctx_t;
+_Static_assert(sizeof(clip_ctx_t) <= RGB_EFFECT_CTX_MAX, "clip_ctx_t exceeds arena slot");
+
+// Bumped by core 0 when an upload starts and when it ends
+static volatile uint32_t rgb_clip_generation = 1;
+static volatile bool rgb_clip_writing = false; // Partition is being rewritten
+
+static inline const rgb_clip_header_t *rgb_clip_header(void)
+{
+  return (const rgb_clip_header_t *)(XIP_BASE + RGB_CLIP_FLASH_OFFSET);
+}
+
+/**
+ * Header sanity only; the data CRC is checked once, when it is uploaded
+ **/
+static bool rgb_clip_check(const rgb_clip_header_t *h)
+{
+  return h->magic == RGB_CLIP_MAGIC && h->leds == WS2812B_LED_SIZE && h->frames && h->frame_ms &&
+         h->data_len <= RGB_CLIP_FLASH_SIZE - sizeof(*h);
+}
+
+/**
+ * Decode the next frame over the current one
+ * @return false if the data is malformed
+ **/
+static bool rgb_clip_decode(clip_ctx_t *cc, const rgb_clip_header_t *h)
+{
+  if (cc->pos >= h->data_len)
+    return false;
+  uint16_t px = 0;
+  int32_t used = rgb_delta_decode(cc->frame, &px, WS2812B_LED_SIZE, (const uint8_t *)(h + 1) + cc->pos,
+                                  h->data_len - cc->pos);
+  if (used < 0 || px != WS2812B_LED_SIZE)
+    return false;
+  cc->pos += (uint32_t)used;
+  cc->index++;
+  return true;
+}
+
+/**
+ * Back to frame 0 (a keyframe over black)
+ **/
+static void rgb_clip_rewind(clip_ctx_t *cc, const rgb_clip_header_t *h)
+{
+  memset(cc->frame, 0, sizeof(cc->frame));
+  cc->pos = 0;
+  cc->index = 0;
+  cc->valid = rgb_clip_decode(cc, h);
+}
+
+void ws_clip(void *ctx, const rgb_frame_t *frame)
+{
+  clip_ctx_t *cc = ctx;
+  const rgb_clip_header_t *h = rgb_clip_header();
+  uint32_t gen = rgb_clip_generation;
+  if (rgb_clip_writing)
+  {
+    memset(leds, 0, sizeof(leds));
+    return;
+  }
+  bool loaded = cc->generation != gen;
+  if (loaded)
+  {
+    cc->generation = gen;
+    cc->elapsed_ms = 0;
+    cc->valid = rgb_clip_check(h);
+    if (cc->valid)
+      rgb_clip_rewind(cc, h);
+  }
+  if (!cc->valid)
+  {
+    memset(leds, 0, sizeof(leds));
+    return;
+  }
+
+  // Advance by whole frames; after a long stall skip ahead at most one loop
+  cc->elapsed_ms += loaded ? 0 : frame->dt_ms;
+  uint32_t steps = cc->elapsed_ms / h->frame_ms;
+  cc->elapsed_ms %= h->frame_ms;
+  if (steps > h->frames)
+    steps = h->frames;
+  while (steps-- && cc->valid)
+  {
+    if (cc->index < h->frames)
+      cc->valid = rgb_clip_decode(cc, h);
+    else if (h->flags & RGB_CLIP_LOOP)
+      rgb_clip_rewind(cc, h);
+    else
+      break; // Hold the last frame
+  }
+  memcpy(leds, cc->frame, sizeof(leds));
+}
+
+// ---- Upload (core 0, from the HID config callback) ----
+// Data must arrive in order; each page is queued for flash_task() as it
+// fills, erasing its sector first if it is the sector's first page, so the
+// partition never has to fit in RAM. A page buffer is reused only after
+// more pages than the queue holds, so it has been written by then.
+
+#define RGB_CLIP_UPLOAD_IDLE 0
+#define RGB_CLIP_UPLOAD_RECEIVING 1
+#define RGB_CLIP_UPLOAD_STORED 2
+#define RGB_CLIP_UPLOAD_REJECTED 3
+#define RGB_CLIP_UPLOAD_WRITING 4 // Committed, last pages queued for flash_task()
+#define RGB_CLIP_PAGE_BUFS (FLASH_JOBS + 1)
+
+static uint8_t rgb_clip_pages[RGB_CLIP_PAGE_BUFS][FLASH_PAGE_SZ];
+static uint8_t *rgb_clip_page = rgb_clip_pages[0]; // Page being filled
+static uint8_t rgb_clip_page_buf = 0;
+static uint32_t rgb_clip_next = 0; // Next expected byte offset
+static uint32_t rgb_clip_crc = 0;  // Running CRC of the frame data
+static uint8_t rgb_clip_upload_state = RGB_CLIP_UPLOAD_IDLE;
+
+static void rgb_clip_flush_page(void)
+{
+  uint32_t page = (rgb_clip_next - 1) / FLASH_PAGE_SZ * FLASH_PAGE_SZ;
+  flash_queue(RGB_CLIP_FLASH_OFFSET + page, rgb_clip_page, FLASH_PAGE_SZ, page % FLASH_SECTOR_SZ == 0, NULL);
+  rgb_clip_page_buf = (uint8_t)((rgb_clip_page_buf + 1) % RGB_CLIP_PAGE_BUFS);
+  rgb_clip_page = rgb_clip_pages[rgb_clip_page_buf];
+  memset(rgb_clip_page, 0xFF, FLASH_PAGE_SZ);
+}
+
+static void rgb_clip_upload_begin(void)
+{
+  flash_flush(); // Let a previous upload finish first
+  rgb_clip_writing = true;
+  rgb_clip_generation++;
+  memset(rgb_clip_page, 0xFF, FLASH_PAGE_SZ);
+  rgb_clip_next = 0;
+  rgb_clip_crc = 0xFFFFFFFFu;
+  rgb_clip_upload_state = RGB_CLIP_UPLOAD_RECEIVING;
+}
+
+static void rgb_clip_upload_done(void)
+{
+  rgb_clip_generation++;
+  rgb_clip_writing = false;
+}
+
+/**
+ * Wipe the header behind the pages already queued or written, so a
+ * truncated image never plays
+ **/
+static void rgb_clip_upload_reject(void)
+{
+  rgb_clip_upload_state = RGB_CLIP_UPLOAD_REJECTED;
+  memset(rgb_clip_page, 0xFF, FLASH_PAGE_SZ);
+  flash_queue(RGB_CLIP_FLASH_OFFSET, rgb_clip_page, FLASH_PAGE_SZ, true, rgb_clip_upload_done); // Erase the header
+}
+
+/**
+ * Append a chunk; anything out of order or past the partition rejects the upload
+ **/
+static void rgb_clip_upload_data(uint32_t offset, const uint8_t *data, uint16_t len)
+{
+  if (rgb_clip_upload_state != RGB_CLIP_UPLOAD_RECEIVING)
+    return;
+  if (offset != rgb_clip_next || offset + len > RGB_CLIP_FLASH_SIZE)
+  {
+    rgb_clip_upload_reject();
+    return;
+  }
+  for (uint16_t i = 0; i < len; ++i)
+  {
+    rgb_clip_page[rgb_clip_next % FLASH_PAGE_SZ] = data[i];
+    if (rgb_clip_next >= sizeof(rgb_clip_header_t))
+      rgb_clip_crc = crc32_update(rgb_clip_crc, &data[i], 1);
+    if (++rgb_clip_next % FLASH_PAGE_SZ == 0)
+      rgb_clip_flush_page();
+  }
+}
+
+/**
+ * Check the stored image once its last page is written; a bad one is wiped
+ **/
+static void rgb_clip_upload_verify(void)
+{
+  const rgb_clip_header_t *h = rgb_clip_header();
+  if (rgb_clip_next >= sizeof(*h) && rgb_clip_check(h) &&
+      h->data_len == rgb_clip_next - sizeof(*h) && h->crc32 == ~rgb_clip_crc)
+  {
+    rgb_clip_upload_state = RGB_CLIP_UPLOAD_STORED;
+    rgb_clip_upload_done();
+    return;
+  }
+  rgb_clip_upload_reject();
+}
+
+/**
+ * Queue the last page; rgb_clip_upload_verify() runs once it is written
+ **/
+static void rgb_clip_upload_commit(void)
+{
+  if (rgb_clip_upload_state != RGB_CLIP_UPLOAD_RECEIVING)
+    return;
+  rgb_clip_upload_state = RGB_CLIP_UPLOAD_WRITING;
+  if (rgb_clip_next % FLASH_PAGE_SZ)
+    rgb_clip_flush_page();
+  flash_queue(0, NULL, 0, false, rgb_clip_upload_verify);
+}
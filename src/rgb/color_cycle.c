@@ -3,15 +3,15 @@
  * @author SpeedyPotato
  **/
 
-void ws2812b_color_cycle(uint32_t counter, bool hid_mode)
+void ws2812b_color_cycle(void *ctx, const rgb_frame_t *frame)
 {
-  // Cycle through palettes every ~15 seconds at 200Hz (3000 cycles)
-  int cycle_palette = PALETTE_PLASMA; //(counter / 3000) % 9; // 9 palettes available (0-8)
-  set_color_palette(cycle_palette);
+  (void)ctx; // stateless
+  // Palette comes from the effect's parameters (Plasma by default)
+  uint32_t wheel = frame->time_ms / 5; // 200 wheel steps per second
 
   for (int i = 0; i < WS2812B_LED_SIZE; ++i)
   {
-    uint32_t color = color_wheel((counter + i * (int)(768 / WS2812B_LED_SIZE)) % 768);
+    uint32_t color = color_wheel((wheel + led_layout[i].wheel) % 768);
     // Extract RGB from color and set in leds array
     leds[i].r = (color >> 8) & 0xFF;  // R is in bits 15-8
     leds[i].g = (color >> 16) & 0xFF; // G is in bits 23-16
@@ -0,0 +1,187 @@
+/**
+ * Layer compositor - a base effect plus reactive overlay effects
+ * @author Renard
+ *
+ * Layer 0 is the selected base effect and renders straight into leds[].
+ * Overlay layers render with frame->overlay set (no palette background) and
+ * are merged over the result with an integer blend mode and opacity, so any
+ * background can be paired with any reactive layer.
+ *
+ * Core 0 changes layers with rgb_layer_select(); core 1 applies the change
+ * (lifecycle hooks + crossfade) at the start of its next frame.
+ **/
+
+#define RGB_LAYERS (1 + RGB_OVERLAY_LAYERS)
+#define RGB_LAYER_OFF 0xFF
+
+enum
+{
+  RGB_BLEND_ADD = 0,    // Saturating sum
+  RGB_BLEND_SCREEN = 1, // 1 - (1 - a)(1 - b), brightens without clipping
+  RGB_BLEND_MAX = 2,    // Per-channel lighten
+  RGB_BLEND_ALPHA = 3,  // Overlay covers base by its peak channel
+  RGB_BLEND_COUNT
+};
+
+typedef struct
+{
+  uint8_t effect_id; // RGB_LAYER_OFF to disable (overlays only)
+  uint8_t blend;     // RGB_BLEND_*
+  uint8_t opacity;   // 0..255
+  uint8_t seq;       // Bumped on every selection, even of the same effect
+} rgb_layer_t;
+
+// Written by core 0, read by core 1
+static volatile rgb_layer_t rgb_layers[RGB_LAYERS] = {
+    [1 ... RGB_LAYERS - 1] = {.effect_id = RGB_LAYER_OFF, .blend = RGB_BLEND_SCREEN, .opacity = 255},
+};
+
+// Core 1 state
+static rgb_instance_t rgb_layer_inst[RGB_LAYERS];
+static uint8_t rgb_layer_applied_seq[RGB_LAYERS];
+static bool rgb_layers_started = false;
+static RGB_t rgb_comp[WS2812B_LED_SIZE];
+static rgb_transition_t rgb_layer_transition;
+
+/**
+ * Select the effect shown on a layer (core 0)
+ * @param layer 0 = base, 1..RGB_OVERLAY_LAYERS = overlays
+ * @param effect_id Registry index; RGB_LAYER_OFF disables an overlay
+ **/
+static void rgb_layer_select(uint8_t layer, uint8_t effect_id, uint8_t blend, uint8_t opacity)
+{
+  if (layer >= RGB_LAYERS)
+    return;
+  if (effect_id >= RGB_EFFECT_COUNT)
+    effect_id = layer == 0 ? 0 : RGB_LAYER_OFF;
+  rgb_layers[layer].effect_id = effect_id;
+  rgb_layers[layer].blend = blend < RGB_BLEND_COUNT ? blend : RGB_BLEND_SCREEN;
+  rgb_layers[layer].opacity = opacity;
+  rgb_layers[layer].seq++;
+}
+
+/**
+ * Merge an overlay into the composite in integer arithmetic
+ * @param dst Composite so far (updated in place)
+ * @param src Overlay frame
+ **/
+static void rgb_blend_layer(RGB_t *dst, const RGB_t *src, uint8_t mode, uint8_t opacity)
+{
+  const uint32_t op = rgb_weight(opacity);
+  for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+  {
+    uint32_t s = rgb_px_scale(src[i].u, op);
+    switch (mode)
+    {
+    case RGB_BLEND_ADD:
+      dst[i].u = rgb_px_add_sat(dst[i].u, s);
+      break;
+    case RGB_BLEND_MAX:
+      dst[i].u = rgb_px_max(dst[i].u, s);
+      break;
+    case RGB_BLEND_ALPHA:
+    {
+      // Coverage from the overlay's brightest channel: black stays transparent
+      uint8_t peak = src[i].r > src[i].g ? src[i].r : src[i].g;
+      peak = peak > src[i].b ? peak : src[i].b;
+      dst[i].u = rgb_px_lerp(dst[i].u, src[i].u, (rgb_weight(peak) * op) >> 8);
+      break;
+    }
+    case RGB_BLEND_SCREEN:
+    default:
+    {
+      // Per-channel product, so this one stays scalar
+      RGB_t d = dst[i], o = {.u = s};
+      d.r += o.r - ((d.r * o.r + 255) >> 8);
+      d.g += o.g - ((d.g * o.g + 255) >> 8);
+      d.b += o.b - ((d.b * o.b + 255) >> 8);
+      dst[i] = d;
+      break;
+    }
+    }
+  }
+}
+
+/**
+ * Apply pending layer selections (core 1)
+ * @param transition_ms Crossfade applied when anything changed
+ **/
+static void rgb_layers_sync(uint32_t transition_ms)
+{
+  bool changed = false;
+  for (int l = 0; l < RGB_LAYERS; ++l)
+  {
+    uint8_t seq = rgb_layers[l].seq;
+    if (rgb_layers_started && seq == rgb_layer_applied_seq[l])
+      continue;
+    uint8_t id = rgb_layers[l].effect_id;
+    rgb_instance_t *inst = &rgb_layer_inst[l];
+    if (inst->effect && inst->effect == &rgb_effects[id])
+    {
+      rgb_instance_reset(inst); // Re-selected: restart in place
+    }
+    else
+    {
+      rgb_instance_stop(inst);
+      if (id < RGB_EFFECT_COUNT)
+        rgb_instance_start(inst, &rgb_effects[id]);
+    }
+    rgb_layer_applied_seq[l] = seq;
+    changed = true;
+  }
+  // Fade from whatever was last shown (including a half-finished fade)
+  if (changed && rgb_layers_started)
+    rgb_transition_begin(&rgb_layer_transition, transition_ms);
+  rgb_layers_started = true;
+}
+
+/**
+ * True when nothing on screen can change until core 0 rings the doorbell:
+ * every active layer is static, no selection is pending and no fade runs
+ **/
+static bool rgb_compositor_static(void)
+{
+  if (rgb_layer_transition.duration_ms)
+    return false;
+  for (int l = 0; l < RGB_LAYERS; ++l)
+  {
+    if (rgb_layers[l].seq != rgb_layer_applied_seq[l])
+      return false;
+    const rgb_effect_t *e = rgb_layer_inst[l].effect;
+    if (e && !(e->flags & EFFECT_FLAG_STATIC))
+      return false;
+  }
+  return true;
+}
+
+/**
+ * Render all layers into leds[] (core 1)
+ * @param transition_ms Crossfade used if the layer selection changed
+ **/
+static void rgb_compositor_render(const rgb_frame_t *frame, uint32_t transition_ms)
+{
+  rgb_layers_sync(transition_ms);
+
+  rgb_frame_t f = *frame;
+  f.overlay = false;
+  rgb_instance_render(&rgb_layer_inst[0], &f);
+
+  bool composited = false;
+  f.overlay = true;
+  for (int l = 1; l < RGB_LAYERS; ++l)
+  {
+    if (!rgb_layer_inst[l].effect)
+      continue;
+    if (!composited)
+    {
+      memcpy(rgb_comp, leds, sizeof(rgb_comp));
+      composited = true;
+    }
+    rgb_instance_render(&rgb_layer_inst[l], &f);
+    rgb_blend_layer(rgb_comp, leds, rgb_layers[l].blend, rgb_layers[l].opacity);
+  }
+  if (composited)
+    memcpy(leds, rgb_comp, sizeof(rgb_comp));
+
+  rgb_transition_apply(&rgb_layer_transition, frame->dt_ms);
+}
@@ -0,0 +1,200 @@
+/**
+ * Uploaded palettes - user gradients baked into the palette tables
+ * @author Renard
+ *
+ * A custom palette is a list of gradient stops (position around the wheel
+ * 0..255 and a color), uploaded over HID into one of RGB_CUSTOM_PALETTES
+ * slots in the palette sector (RGB_PALETTE_FLASH_OFFSET). Core 1 bakes the
+ * stored slots into rgb_palette_lut[PALETTE_CUSTOM + slot], the same table
+ * format as the built-in palettes, so they cost the same per pixel and
+ * effects select them through their palette parameter.
+ *
+ * The gradient wraps: the last stop blends back into the first. Empty or
+ * damaged slots bake as the rainbow palette.
+ **/
+
+#define RGB_PALETTE_MAGIC 0x314C4150u // 'PAL1' LE
+#define RGB_PALETTE_STOPS_MAX 16
+
+typedef struct
+{
+  uint32_t magic; // RGB_PALETTE_MAGIC
+  uint8_t stops;  // 1..RGB_PALETTE_STOPS_MAX
+  uint8_t reserved[3];
+  uint8_t stop[RGB_PALETTE_STOPS_MAX][4]; // pos, r, g, b; pos ascending
+  uint32_t crc32;                         // Over stops..stop[]
+} rgb_palette_slot_t;
+
+// The palette sector holds the slots back to back, rewritten as a whole
+#define RGB_PALETTE_IMAGE_SIZE ((RGB_CUSTOM_PALETTES * sizeof(rgb_palette_slot_t) + FLASH_PAGE_SZ - 1) / FLASH_PAGE_SZ * FLASH_PAGE_SZ)
+_Static_assert(RGB_PALETTE_IMAGE_SIZE <= FLASH_SECTOR_SZ, "custom palettes exceed their sector");
+
+// Bumped by core 0 after a slot is stored; core 1 rebakes when it changes
+static volatile uint32_t rgb_palette_generation = 1;
+static uint32_t rgb_palette_baked = 0; // Core 1
+
+static inline const rgb_palette_slot_t *rgb_palette_slot(int slot)
+{
+  return (const rgb_palette_slot_t *)(XIP_BASE + RGB_PALETTE_FLASH_OFFSET) + slot;
+}
+
+static inline uint32_t rgb_palette_slot_crc(const rgb_palette_slot_t *s)
+{
+  return ~crc32_update(0xFFFFFFFFu, &s->stops, offsetof(rgb_palette_slot_t, crc32) - offsetof(rgb_palette_slot_t, stops));
+}
+
+/**
+ * Whether a slot holds a usable gradient
+ **/
+static bool rgb_palette_slot_check(const rgb_palette_slot_t *s)
+{
+  if (s->magic != RGB_PALETTE_MAGIC || !s->stops || s->stops > RGB_PALETTE_STOPS_MAX)
+    return false;
+  for (int k = 1; k < s->stops; ++k)
+    if (s->stop[k][0] < s->stop[k - 1][0])
+      return false;
+  return rgb_palette_slot_crc(s) == s->crc32;
+}
+
+/**
+ * Bake a gradient into a palette table
+ **/
+static void rgb_palette_bake(uint32_t *lut, const rgb_palette_slot_t *s)
+{
+  int n = s->stops, k = -1; // Last stop at or before the entry
+  for (int i = 0; i < RGB_PALETTE_LUT_SIZE; ++i)
+  {
+    while (k + 1 < n && s->stop[k + 1][0] <= i)
+      k++;
+    int a = k < 0 ? n - 1 : k; // Before the first stop: still blending from the last one
+    int nk = (a + 1) % n;
+    int p0 = s->stop[a][0], p1 = s->stop[nk][0];
+    int pos = i;
+    if (p1 <= p0) // Wrapping segment (or a single stop)
+    {
+      p1 += RGB_PALETTE_LUT_SIZE;
+      if (pos < p0)
+        pos += RGB_PALETTE_LUT_SIZE;
+    }
+    uint32_t from = urgb_u32(s->stop[a][1], s->stop[a][2], s->stop[a][3]);
+    uint32_t to = urgb_u32(s->stop[nk][1], s->stop[nk][2], s->stop[nk][3]);
+    lut[i] = rgb_px_lerp(from, to, (uint32_t)((pos - p0) * 256 / (p1 - p0)));
+  }
+  lut[RGB_PALETTE_LUT_SIZE] = lut[0];
+}
+
+/**
+ * Rebake the uploaded slots if any changed (core 1, before rendering)
+ **/
+static void rgb_custom_palettes_sync(void)
+{
+  uint32_t gen = rgb_palette_generation;
+  if (gen == rgb_palette_baked)
+    return;
+  rgb_palette_baked = gen;
+  for (int slot = 0; slot < RGB_CUSTOM_PALETTES; ++slot)
+  {
+    uint32_t *lut = rgb_palette_lut[PALETTE_CUSTOM + slot];
+    const rgb_palette_slot_t *s = rgb_palette_slot(slot);
+    if (rgb_palette_slot_check(s))
+      rgb_palette_bake(lut, s);
+    else
+      memcpy(lut, rgb_palette_lut[PALETTE_RAINBOW], sizeof(rgb_palette_lut[0]));
+  }
+}
+
+// ---- Upload (core 0, from the HID config callback) ----
+// One slot at a time: BEGIN names the slot and stop count, each STOP fills
+// one stop, COMMIT checks them and queues the rewritten sector for
+// flash_task(). Zero stops clears the slot.
+
+#define RGB_PALETTE_UPLOAD_IDLE 0
+#define RGB_PALETTE_UPLOAD_RECEIVING 1
+#define RGB_PALETTE_UPLOAD_STORED 2
+#define RGB_PALETTE_UPLOAD_REJECTED 3
+#define RGB_PALETTE_UPLOAD_WRITING 4 // Committed, queued for flash_task()
+
+static uint8_t rgb_palette_image[RGB_PALETTE_IMAGE_SIZE] __attribute__((aligned(4)));
+static rgb_palette_slot_t rgb_palette_staging;
+static uint8_t rgb_palette_upload_slot = 0;
+static uint16_t rgb_palette_received = 0; // Bitmask of stops filled in
+static uint8_t rgb_palette_upload_state = RGB_PALETTE_UPLOAD_IDLE;
+
+static void rgb_palette_upload_begin(uint8_t slot, uint8_t stops)
+{
+  if (slot >= RGB_CUSTOM_PALETTES || stops > RGB_PALETTE_STOPS_MAX)
+  {
+    rgb_palette_upload_state = RGB_PALETTE_UPLOAD_REJECTED;
+    return;
+  }
+  flash_flush(); // The next commit rebuilds the image from flash
+  memset(&rgb_palette_staging, 0, sizeof(rgb_palette_staging));
+  rgb_palette_staging.stops = stops;
+  rgb_palette_upload_slot = slot;
+  rgb_palette_received = 0;
+  rgb_palette_upload_state = RGB_PALETTE_UPLOAD_RECEIVING;
+}
+
+static void rgb_palette_upload_stop(uint8_t index, uint8_t pos, uint8_t r, uint8_t g, uint8_t b)
+{
+  if (rgb_palette_upload_state != RGB_PALETTE_UPLOAD_RECEIVING)
+    return;
+  if (index >= rgb_palette_staging.stops)
+  {
+    rgb_palette_upload_state = RGB_PALETTE_UPLOAD_REJECTED;
+    return;
+  }
+  uint8_t *st = rgb_palette_staging.stop[index];
+  st[0] = pos;
+  st[1] = r;
+  st[2] = g;
+  st[3] = b;
+  rgb_palette_received |= 1u << index;
+}
+
+static void rgb_palette_upload_stored(void)
+{
+  rgb_palette_generation++;
+  rgb_palette_upload_state = RGB_PALETTE_UPLOAD_STORED;
+}
+
+/**
+ * Check the staged stops and queue the palette sector rewritten with them
+ **/
+static void rgb_palette_upload_commit(void)
+{
+  if (rgb_palette_upload_state != RGB_PALETTE_UPLOAD_RECEIVING)
+    return;
+  rgb_palette_slot_t *s = &rgb_palette_staging;
+  uint8_t n = s->stops;
+  if (n)
+  {
+    s->magic = RGB_PALETTE_MAGIC;
+    s->crc32 = rgb_palette_slot_crc(s);
+    if (rgb_palette_received != (uint16_t)((1u << n) - 1) || !rgb_palette_slot_check(s))
+    {
+      rgb_palette_upload_state = RGB_PALETTE_UPLOAD_REJECTED;
+      return;
+    }
+  }
+  else
+  {
+    memset(s, 0xFF, sizeof(*s)); // Cleared slot reads as erased flash
+  }
+  memcpy(rgb_palette_image, rgb_palette_slot(0), sizeof(rgb_palette_image));
+  memcpy(rgb_palette_image + rgb_palette_upload_slot * sizeof(*s), s, sizeof(*s));
+  rgb_palette_upload_state = RGB_PALETTE_UPLOAD_WRITING;
+  flash_queue(RGB_PALETTE_FLASH_OFFSET, rgb_palette_image, sizeof(rgb_palette_image), true, rgb_palette_upload_stored);
+}
+
+/**
+ * Bitmask of slots holding a valid palette
+ **/
+static uint8_t rgb_custom_palettes_valid(void)
+{
+  uint8_t mask = 0;
+  for (int slot = 0; slot < RGB_CUSTOM_PALETTES; ++slot)
+    if (rgb_palette_slot_check(rgb_palette_slot(slot)))
+      mask |= 1u << slot;
+  return mask;
+}
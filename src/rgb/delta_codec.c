@@ -0,0 +1,67 @@
+/**
+ * Delta token codec shared by clips (clip.c) and host streaming (host_stream.c)
+ * @author Renard
+ *
+ * A frame is rewritten from the one before it by a series of tokens:
+ *
+ *   00nnnnnn               skip n+1 pixels (unchanged)
+ *   01nnnnnn r g b         n+1 pixels of one color
+ *   10nnnnnn (r g b)*(n+1) n+1 literal pixels
+ *   11xxxxxx               invalid
+ *
+ * Every token is bounds-checked against both the data and the frame, so
+ * malformed input is rejected instead of writing outside the frame.
+ **/
+
+#define RGB_DELTA_SKIP 0
+#define RGB_DELTA_RUN 1
+#define RGB_DELTA_LITERAL 2
+#define RGB_DELTA_MAX_RUN 64
+
+/**
+ * Apply tokens to a frame
+ * @param dst Frame being rewritten
+ * @param px Pixel to continue at; advanced past the decoded tokens
+ * @param n_px Frame length in pixels; decoding stops when it is reached
+ * @param data Tokens
+ * @param len Bytes available
+ * @return Bytes consumed, or -1 if a token is malformed or truncated
+ **/
+static int32_t rgb_delta_decode(RGB_t *dst, uint16_t *px, uint16_t n_px, const uint8_t *data, uint32_t len)
+{
+  uint32_t pos = 0;
+  uint16_t p = *px;
+  while (p < n_px && pos < len)
+  {
+    uint8_t tag = data[pos++];
+    uint16_t n = (tag & 0x3F) + 1;
+    if (n > n_px - p)
+      return -1;
+    switch (tag >> 6)
+    {
+    case RGB_DELTA_SKIP:
+      break;
+    case RGB_DELTA_RUN:
+    {
+      if (len - pos < 3)
+        return -1;
+      uint32_t c = rgb_pack(data[pos], data[pos + 1], data[pos + 2]);
+      pos += 3;
+      for (uint16_t i = 0; i < n; ++i)
+        dst[p + i].u = c;
+      break;
+    }
+    case RGB_DELTA_LITERAL:
+      if (len - pos < 3u * n)
+        return -1;
+      for (uint16_t i = 0; i < n; ++i, pos += 3)
+        dst[p + i].u = rgb_pack(data[pos], data[pos + 1], data[pos + 2]);
+      break;
+    default:
+      return -1;
+    }
+    p += n;
+  }
+  *px = p;
+  return (int32_t)pos;
+}
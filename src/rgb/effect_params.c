@@ -0,0 +1,85 @@
+/**
+ * Per-effect tunable parameters
+ * @author Renard
+ *
+ * Every effect has the same small parameter block - speed, palette, width
+ * and decay - and declares in the registry which of them it uses, with a
+ * typed descriptor (range and default) for each. Values are set over the
+ * config report and stored per effect in the settings.
+ *
+ * Core 0 writes values and bumps rgb_params_seq; core 1 turns them into
+ * the derived constants below when it sees a new seq, once per change and
+ * never per pixel. Speed is applied by running the effect on its own
+ * clock (see rgb_instance_render()), so effects that animate from
+ * frame->time_ms/dt_ms follow it without code of their own; the palette
+ * is selected before the effect renders, so color_wheel() already uses it.
+ **/
+
+// Parameter slots (same for every effect)
+#define RGB_PARAM_SPEED 0
+#define RGB_PARAM_PALETTE 1
+#define RGB_PARAM_WIDTH 2
+#define RGB_PARAM_DECAY 3
+#define RGB_PARAM_COUNT 4
+
+// Descriptor types (value units)
+#define RGB_PARAM_T_NONE 0    // Slot unused by this effect
+#define RGB_PARAM_T_SPEED 1   // Animation rate in 1/64 (64 = as tuned)
+#define RGB_PARAM_T_PALETTE 2 // PALETTE_*, or PALETTE_CUSTOM + uploaded slot
+#define RGB_PARAM_T_WIDTH 3   // Falloff width in 1/8 LED
+#define RGB_PARAM_T_DECAY 4   // Level lost per 5 ms tick
+
+#define RGB_PARAM_DEFAULT 0xFF // SET value restoring the default
+#define RGB_PARAM_EFFECTS_MAX 24 // Effects with a stored block (settings layout)
+
+typedef struct
+{
+  uint8_t type; // RGB_PARAM_T_*
+  uint8_t min, max, def;
+} rgb_param_desc_t;
+
+// Common descriptors for rgb_effects[].params (in slot order)
+#define RGB_PARAM_NONE {RGB_PARAM_T_NONE, 0, 0, 0}
+#define RGB_PARAM_SPEED_DESC {RGB_PARAM_T_SPEED, 8, 254, 64} // 1/8x .. 4x
+#define RGB_PARAM_PALETTE_DESC(p) {RGB_PARAM_T_PALETTE, 0, RGB_PALETTE_TOTAL - 1, (p)}
+#define RGB_PARAM_WIDTH_DESC(w) {RGB_PARAM_T_WIDTH, 2, 128, (w)}
+#define RGB_PARAM_DECAY_DESC(d) {RGB_PARAM_T_DECAY, 1, 64, (d)}
+
+// Derived constants handed to the effect as frame->params
+typedef struct rgb_params
+{
+  uint32_t speed_q16; // Clock rate, 65536 = as tuned
+  uint8_t palette;    // PALETTE_*
+  uint8_t decay;      // Level lost per 5 ms tick
+  float falloff;      // 1 / width in LEDs, for exp(-d * falloff) profiles
+} rgb_params_t;
+
+// Raw values per effect: written by core 0, read by core 1 on a new seq
+static volatile uint8_t rgb_param_values[RGB_PARAM_EFFECTS_MAX][RGB_PARAM_COUNT];
+static volatile uint8_t rgb_params_seq = 0;
+
+/**
+ * Whether a value is accepted for a descriptor
+ **/
+static inline bool rgb_param_valid(const rgb_param_desc_t *d, uint8_t v)
+{
+  return d->type != RGB_PARAM_T_NONE && v >= d->min && v <= d->max;
+}
+
+/**
+ * Turn a parameter block into derived constants; unused or out-of-range
+ * slots take their default
+ * @param desc The effect's descriptors
+ * @param values Raw values, RGB_PARAM_COUNT of them
+ **/
+static void rgb_params_derive(rgb_params_t *p, const rgb_param_desc_t *desc, const volatile uint8_t *values)
+{
+  uint8_t v[RGB_PARAM_COUNT];
+  for (int i = 0; i < RGB_PARAM_COUNT; ++i)
+    v[i] = rgb_param_valid(&desc[i], values[i]) ? values[i] : desc[i].def;
+
+  p->speed_q16 = desc[RGB_PARAM_SPEED].type ? (uint32_t)v[RGB_PARAM_SPEED] << 10 : 65536;
+  p->palette = desc[RGB_PARAM_PALETTE].type ? v[RGB_PARAM_PALETTE] : PALETTE_SUNSET;
+  p->decay = v[RGB_PARAM_DECAY];
+  p->falloff = v[RGB_PARAM_WIDTH] ? 8.0f / v[RGB_PARAM_WIDTH] : 1.0f;
+}
@@ -0,0 +1,249 @@
+/**
+ * Effect registry - the single list of selectable RGB effects
+ * @author Renard
+ *
+ * The array index is the effect ID used by the HID config report and stored
+ * in flash, so only ever append new entries. Names and input flags are
+ * enumerable from the host (see CMD_GET_EFFECT_INFO).
+ *
+ * Effect state is a context struct of ctx_size bytes, handed out from a
+ * shared arena when the effect starts. Lifecycle (all on core 1):
+ * - init: ctx is zeroed, then init() runs
+ * - reset: reset() if provided, otherwise zero + init() again
+ * - teardown: runs before the slot is handed to another effect
+ *
+ * params declares which of the shared tunables (effect_params.c) the effect
+ * uses, in slot order; the defaults are the values it was tuned with.
+ **/
+
+// Inputs an effect reacts to (reported to the host as a bitmask)
+#define EFFECT_INPUT_ENCODER 0x01
+#define EFFECT_INPUT_BUTTONS 0x02
+#define EFFECT_INPUT_HID_RGB 0x04
+
+// Behaviour flags
+#define EFFECT_FLAG_STATIC 0x01 // Output changes only with input/HID colors, never with time
+
+typedef struct
+{
+  const char *name;
+  void (*render)(void *ctx, const rgb_frame_t *frame);
+  uint8_t inputs;
+  uint8_t flags;
+  uint16_t ctx_size;           // 0 = stateless
+  void (*init)(void *ctx);     // Optional
+  void (*reset)(void *ctx);    // Optional
+  void (*teardown)(void *ctx); // Optional
+  rgb_param_desc_t params[RGB_PARAM_COUNT];
+} rgb_effect_t;
+
+static const rgb_effect_t rgb_effects[] = {
+    {.name = "Color Cycle", .render = ws2812b_color_cycle, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_PLASMA)}},
+    {.name = "Turbocharger", .render = turbocharger_color_cycle, .inputs = EFFECT_INPUT_ENCODER, .ctx_size = sizeof(turbo_ctx_t), .params = {RGB_PARAM_SPEED_DESC}},
+    {.name = "Trail", .render = ws2812b_trail, .inputs = EFFECT_INPUT_ENCODER, .ctx_size = sizeof(trail_ctx_t), .init = ws2812b_trail_init, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_NEON), RGB_PARAM_NONE, RGB_PARAM_DECAY_DESC(16)}},
+    {.name = "Dual Orbit", .render = ws_dual_orbit, .inputs = EFFECT_INPUT_ENCODER | EFFECT_INPUT_HID_RGB, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_NEON), RGB_PARAM_WIDTH_DESC(10)}},
+    {.name = "Velocity Comet", .render = ws_velocity_comet, .inputs = EFFECT_INPUT_ENCODER, .ctx_size = sizeof(velocity_comet_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_PLASMA), RGB_PARAM_NONE, RGB_PARAM_DECAY_DESC(2)}},
+    {.name = "Button Ripples", .render = ws_button_ripples, .inputs = EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(button_ripples_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_OCEAN)}},
+    {.name = "Spokes", .render = ws_spokes, .inputs = EFFECT_INPUT_ENCODER | EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(spokes_ctx_t), .params = {RGB_PARAM_SPEED_DESC}},
+    {.name = "Counter Stripes", .render = ws_counter_stripes, .inputs = EFFECT_INPUT_HID_RGB, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_FIRE)}},
+    {.name = "Palette Tint Gradient", .render = ws_palette_tint_gradient, .inputs = EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_SUNSET)}},
+    {.name = "Multipoint Snap", .render = ws_multipoint_snap, .inputs = EFFECT_INPUT_ENCODER | EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(multipoint_snap_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_VIRIDIS), RGB_PARAM_WIDTH_DESC(9)}},
+    {.name = "Center Pulse", .render = ws_center_pulse, .inputs = EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(center_pulse_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_ARCTIC), RGB_PARAM_WIDTH_DESC(10)}},
+    {.name = "Sector Equalizer", .render = ws_sector_equalizer, .inputs = EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_EARTH)}},
+    {.name = "Radar Sweep", .render = ws_radar_sweep, .inputs = EFFECT_INPUT_ENCODER | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(radar_sweep_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_RAINBOW), RGB_PARAM_NONE, RGB_PARAM_DECAY_DESC(2)}},
+    {.name = "HID Zones", .render = ws_hid_zones, .inputs = EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .flags = EFFECT_FLAG_STATIC},
+    {.name = "Bytecode", .render = ws_bytecode, .inputs = EFFECT_INPUT_ENCODER | EFFECT_INPUT_BUTTONS | EFFECT_INPUT_HID_RGB, .ctx_size = sizeof(bytecode_ctx_t), .params = {RGB_PARAM_SPEED_DESC, RGB_PARAM_PALETTE_DESC(PALETTE_SUNSET)}},
+    {.name = "Clip", .render = ws_clip, .ctx_size = sizeof(clip_ctx_t), .params = {RGB_PARAM_SPEED_DESC}},
+    {.name = "Host Stream", .render = ws_host_stream, .flags = EFFECT_FLAG_STATIC},
+};
+
+#define RGB_EFFECT_COUNT (sizeof(rgb_effects) / sizeof(rgb_effects[0]))
+
+// Shared scratch arena: one slot per compositor layer (base + overlays), so
+// RAM is bounded by the active layers instead of every effect's state.
+#define RGB_ARENA_SLOTS (1 + RGB_OVERLAY_LAYERS)
+
+static uint32_t rgb_arena[RGB_ARENA_SLOTS][(RGB_EFFECT_CTX_MAX + 3) / 4];
+static uint8_t rgb_arena_used = 0; // Bitmask of slots in use
+
+// A running effect and the arena slot holding its context
+typedef struct
+{
+  const rgb_effect_t *effect;
+  void *ctx;
+  int8_t slot; // -1 when stateless
+  uint8_t params_seq; // rgb_params_seq the derived params were built from
+  bool clock_started;
+  rgb_params_t params; // Derived from the effect's stored parameter block
+  uint64_t clock_q16;  // Effect time in ms, Q16, advanced at params.speed_q16
+  uint32_t clock_ms;   // Effect time handed to the last frame
+} rgb_instance_t;
+
+/**
+ * Rebuild an instance's derived parameters from the stored values
+ **/
+static void rgb_instance_derive(rgb_instance_t *inst)
+{
+  inst->params_seq = rgb_params_seq; // Before the values: a racing change is seen next frame
+  rgb_params_derive(&inst->params, inst->effect->params, rgb_param_values[inst->effect - rgb_effects]);
+}
+
+/**
+ * Start an effect, carving its context from a free arena slot
+ * @return false if the arena has no free slot (instance stays stopped)
+ **/
+static bool rgb_instance_start(rgb_instance_t *inst, const rgb_effect_t *effect)
+{
+  inst->effect = NULL;
+  inst->ctx = NULL;
+  inst->slot = -1;
+  if (effect->ctx_size)
+  {
+    int slot = 0;
+    while (slot < RGB_ARENA_SLOTS && (rgb_arena_used & (1u << slot)))
+      slot++;
+    if (slot == RGB_ARENA_SLOTS)
+      return false;
+    rgb_arena_used |= 1u << slot;
+    inst->slot = slot;
+    inst->ctx = rgb_arena[slot];
+    memset(inst->ctx, 0, effect->ctx_size);
+  }
+  inst->effect = effect;
+  inst->clock_started = false;
+  rgb_instance_derive(inst);
+  if (effect->init)
+    effect->init(inst->ctx);
+  return true;
+}
+
+/**
+ * Return an effect to its initial state without releasing its slot
+ **/
+static void rgb_instance_reset(rgb_instance_t *inst)
+{
+  const rgb_effect_t *effect = inst->effect;
+  if (!effect)
+    return;
+  if (effect->reset)
+  {
+    effect->reset(inst->ctx);
+    return;
+  }
+  if (inst->ctx)
+    memset(inst->ctx, 0, effect->ctx_size);
+  if (effect->init)
+    effect->init(inst->ctx);
+}
+
+/**
+ * Tear an effect down and release its arena slot
+ **/
+static void rgb_instance_stop(rgb_instance_t *inst)
+{
+  if (inst->effect && inst->effect->teardown)
+    inst->effect->teardown(inst->ctx);
+  if (inst->slot >= 0)
+    rgb_arena_used &= ~(1u << inst->slot);
+  inst->effect = NULL;
+  inst->ctx = NULL;
+  inst->slot = -1;
+}
+
+/**
+ * Render one frame of a running instance (stopped instances render black)
+ *
+ * The effect sees time on its own clock, advanced at its speed parameter
+ * from the caller's dt; at 1x it stays equal to the caller's time base.
+ **/
+static void rgb_instance_render(rgb_instance_t *inst, const rgb_frame_t *frame)
+{
+  if (!inst->effect)
+  {
+    memset(leds, 0, sizeof(leds));
+    return;
+  }
+  if (inst->params_seq != rgb_params_seq)
+    rgb_instance_derive(inst);
+
+  rgb_frame_t f = *frame;
+  if (inst->clock_started)
+  {
+    inst->clock_q16 += (uint64_t)frame->dt_ms * inst->params.speed_q16;
+    f.time_ms = (uint32_t)(inst->clock_q16 >> 16);
+    f.dt_ms = f.time_ms - inst->clock_ms;
+  }
+  else
+  {
+    inst->clock_q16 = (uint64_t)frame->time_ms << 16;
+    inst->clock_started = true;
+  }
+  inst->clock_ms = f.time_ms;
+  f.params = &inst->params;
+  set_color_palette(inst->params.palette);
+  inst->effect->render(inst->ctx, &f);
+}
+
+// ---- Parameter blocks (core 0) ----
+
+_Static_assert(RGB_EFFECT_COUNT <= RGB_PARAM_EFFECTS_MAX, "raise RGB_PARAM_EFFECTS_MAX (settings layout)");
+
+/**
+ * Whether an effect has any parameter slot
+ **/
+static bool rgb_effect_has_params(uint8_t effect_id)
+{
+  for (int i = 0; i < RGB_PARAM_COUNT; ++i)
+    if (rgb_effects[effect_id].params[i].type != RGB_PARAM_T_NONE)
+      return true;
+  return false;
+}
+
+/**
+ * Set one parameter of an effect
+ * @param value New value, or RGB_PARAM_DEFAULT
+ * @return false if the effect does not have that parameter or the value is out of range
+ **/
+static bool rgb_param_set(uint8_t effect_id, uint8_t param, uint8_t value)
+{
+  if (effect_id >= RGB_EFFECT_COUNT || param >= RGB_PARAM_COUNT)
+    return false;
+  const rgb_param_desc_t *d = &rgb_effects[effect_id].params[param];
+  if (value == RGB_PARAM_DEFAULT && d->type != RGB_PARAM_T_NONE)
+    value = d->def;
+  if (!rgb_param_valid(d, value))
+    return false;
+  rgb_param_values[effect_id][param] = value;
+  __dmb();
+  rgb_params_seq++;
+  return true;
+}
+
+/**
+ * Load every effect's parameter block, falling back to the defaults
+ * @param blob Stored values (RGB_PARAM_EFFECTS_MAX x RGB_PARAM_COUNT), or NULL for all defaults
+ **/
+static void rgb_params_load(const uint8_t *blob)
+{
+  for (uint32_t e = 0; e < RGB_EFFECT_COUNT; ++e)
+  {
+    for (int i = 0; i < RGB_PARAM_COUNT; ++i)
+    {
+      const rgb_param_desc_t *d = &rgb_effects[e].params[i];
+      uint8_t v = blob ? blob[e * RGB_PARAM_COUNT + i] : d->def;
+      rgb_param_values[e][i] = rgb_param_valid(d, v) ? v : d->def;
+    }
+  }
+  __dmb();
+  rgb_params_seq++;
+}
+
+/**
+ * Copy every effect's parameter block out for saving
+ **/
+static void rgb_params_store(uint8_t *blob)
+{
+  for (int e = 0; e < RGB_PARAM_EFFECTS_MAX; ++e)
+    for (int i = 0; i < RGB_PARAM_COUNT; ++i)
+      blob[e * RGB_PARAM_COUNT + i] = rgb_param_values[e][i];
+}
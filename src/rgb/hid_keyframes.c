@@ -0,0 +1,189 @@
+/**
+ * HID keyframes - host-scheduled color fades interpolated on core 1
+ * @author Renard
+ *
+ * Instead of streaming lights reports for every step of a fade, the host
+ * sends keyframes (HID_KEYFRAME, 0x30): a zone, a target color, a duration,
+ * an easing curve and a start delay. Core 0 timestamps each keyframe and
+ * queues it per zone; core 1 starts it once its time arrives, fading from
+ * whatever the zone shows at that moment, and interpolates every frame.
+ *
+ * A zone follows its keyframes until the next lights report, which takes
+ * over all zones again. The HID timeout counts from the end of the last
+ * scheduled fade, so a long fade sent once keeps HID mode for its length.
+ *
+ * Host test with a simulated clock: tools/bench/hid_keyframes_bench.c
+ *
+ * The queues are single-producer/single-consumer: core 0 only writes
+ * head, core 1 only writes tail. A keyframe sent to a full queue is dropped.
+ **/
+
+#define RGB_KEYFRAME_QUEUE 8 // Per zone, power of two
+#define RGB_KEYFRAME_ALL 0x0F // Zone value addressing every zone
+
+#define RGB_EASE_LINEAR 0
+#define RGB_EASE_IN 1     // Quadratic, slow start
+#define RGB_EASE_OUT 2    // Quadratic, slow end
+#define RGB_EASE_IN_OUT 3 // Smoothstep
+#define RGB_EASE_STEP 4   // Hold, then jump at the end
+#define RGB_EASE_COUNT 5
+
+typedef struct
+{
+  uint64_t start_us; // Receive time + delay
+  uint32_t dur_us;
+  uint32_t color; // Packed RGB_t
+  uint8_t ease;   // RGB_EASE_*
+} rgb_keyframe_t;
+
+static rgb_keyframe_t rgb_kf_queue[WS2812B_LED_ZONES][RGB_KEYFRAME_QUEUE];
+static volatile uint8_t rgb_kf_head[WS2812B_LED_ZONES]; // Core 0
+static volatile uint8_t rgb_kf_tail[WS2812B_LED_ZONES]; // Core 1
+
+// A lights report cancels keyframes: core 0 records the head at that point
+// and bumps the sequence; core 1 discards everything queued before it
+static volatile uint8_t rgb_kf_cancel_head[WS2812B_LED_ZONES];
+static volatile uint32_t rgb_kf_cancel_seq = 0;
+
+// Core 1 playback state per zone
+typedef struct
+{
+  uint32_t from, to; // Packed RGB_t
+  uint64_t start_us;
+  uint32_t dur_us;
+  uint8_t ease;
+  bool active; // Zone follows keyframes rather than the lights report
+} rgb_kf_track_t;
+
+static rgb_kf_track_t rgb_kf_track[WS2812B_LED_ZONES];
+static uint32_t rgb_kf_seen_cancel = 0;
+static bool rgb_kf_running = false; // A fade is running or queued; keep ticking
+
+/**
+ * Queue a keyframe (core 0)
+ * @param zone Zone index or RGB_KEYFRAME_ALL
+ * @param dur_ms Fade length, 0 = jump
+ * @param delay_ms Start offset from now
+ **/
+static void rgb_keyframe_push(uint8_t zone, uint32_t color, uint8_t ease, uint32_t dur_ms, uint32_t delay_ms)
+{
+  if (ease >= RGB_EASE_COUNT)
+    ease = RGB_EASE_LINEAR;
+  uint64_t start = time_us_64() + (uint64_t)delay_ms * 1000u;
+  for (int z = 0; z < WS2812B_LED_ZONES; ++z)
+  {
+    if (zone != RGB_KEYFRAME_ALL && zone != z)
+      continue;
+    uint8_t head = rgb_kf_head[z];
+    if ((uint8_t)(head - rgb_kf_tail[z]) >= RGB_KEYFRAME_QUEUE)
+      continue; // Full
+    rgb_kf_queue[z][head % RGB_KEYFRAME_QUEUE] = (rgb_keyframe_t){
+        .start_us = start, .dur_us = dur_ms * 1000u, .color = color, .ease = ease};
+    __dmb(); // Entry is visible before the head moves
+    rgb_kf_head[z] = head + 1;
+  }
+}
+
+/**
+ * Drop queued and running keyframes (core 0, on a lights report)
+ **/
+static void rgb_keyframe_cancel(void)
+{
+  for (int z = 0; z < WS2812B_LED_ZONES; ++z)
+    rgb_kf_cancel_head[z] = rgb_kf_head[z];
+  __dmb();
+  rgb_kf_cancel_seq++;
+}
+
+/**
+ * Eased progress
+ * @param t Linear progress, 0..256
+ * @return Weight 0..256
+ **/
+static uint32_t rgb_ease(uint8_t ease, uint32_t t)
+{
+  switch (ease)
+  {
+  case RGB_EASE_IN:
+    return t * t >> 8;
+  case RGB_EASE_OUT:
+    return 256 - ((256 - t) * (256 - t) >> 8);
+  case RGB_EASE_IN_OUT:
+    return t * t * (768 - 2 * t) >> 16;
+  case RGB_EASE_STEP:
+    return t < 256 ? 0 : 256;
+  default:
+    return t;
+  }
+}
+
+static uint32_t rgb_kf_color(const rgb_kf_track_t *k, uint64_t now)
+{
+  if (now >= k->start_us + k->dur_us)
+    return k->to;
+  if (now <= k->start_us)
+    return k->from;
+  uint32_t t = (uint32_t)((now - k->start_us) * 256u / k->dur_us);
+  return rgb_px_lerp(k->from, k->to, rgb_ease(k->ease, t));
+}
+
+/**
+ * Apply keyframes to this frame's HID colors (core 1)
+ * Keyframes in a zone start in the order they were sent.
+ * @param rgb Colors from the lights report; zones under keyframe control
+ *            are overwritten with their interpolated color
+ * @param now Frame time
+ * @return End of the latest fade (now while one is queued), 0 if no zone
+ *         follows keyframes; HID activity for the reactive timeout, in the
+ *         future while a fade runs
+ **/
+static uint64_t rgb_keyframes_apply(RGB_t *rgb, uint64_t now)
+{
+  uint32_t cancel = rgb_kf_cancel_seq;
+  __dmb();
+  bool cancelled = cancel != rgb_kf_seen_cancel;
+  rgb_kf_seen_cancel = cancel;
+  uint64_t until = 0;
+  for (int z = 0; z < WS2812B_LED_ZONES; ++z)
+  {
+    rgb_kf_track_t *k = &rgb_kf_track[z];
+    if (cancelled)
+    {
+      rgb_kf_tail[z] = rgb_kf_cancel_head[z];
+      k->active = false;
+    }
+    uint8_t head = rgb_kf_head[z];
+    __dmb();
+    // Start every keyframe whose time has come; a later one cuts an earlier one short
+    while (rgb_kf_tail[z] != head)
+    {
+      const rgb_keyframe_t *kf = &rgb_kf_queue[z][rgb_kf_tail[z] % RGB_KEYFRAME_QUEUE];
+      if (kf->start_us > now)
+      {
+        until = now;
+        break;
+      }
+      uint32_t cur = k->active ? rgb_kf_color(k, kf->start_us) : rgb[z].u;
+      *k = (rgb_kf_track_t){
+          .from = cur, .to = kf->color, .start_us = kf->start_us, .dur_us = kf->dur_us, .ease = kf->ease, .active = true};
+      rgb_kf_tail[z]++;
+    }
+    if (!k->active)
+      continue;
+    rgb[z].u = rgb_kf_color(k, now);
+    if (k->start_us + k->dur_us > until)
+      until = k->start_us + k->dur_us;
+  }
+  rgb_kf_running = until >= now;
+  return until;
+}
+
+/**
+ * Whether the host's colors have timed out (rgb_frame_t.hid_mode)
+ * @param last_us Latest HID activity: a lights report, or the end of a fade,
+ *                which lies ahead of now while the fade runs
+ **/
+static inline bool rgb_hid_timed_out(uint64_t now, uint64_t last_us)
+{
+  return now >= last_us && now - last_us >= REACTIVE_TIMEOUT_MAX;
+}
@@ -0,0 +1,13 @@
+/** Static HID zone colors; held buttons light their wedge at full level **/
+void ws_hid_zones(void *ctx, const rgb_frame_t *frame)
+{
+    (void)ctx;
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+    {
+        bool held = frame->input.buttons & (1u << led_layout[i].button);
+        uint32_t c = hid_rgb[led_layout[i].zone].u;
+        if (!held)
+            c = frame->overlay ? 0 : rgb_px_scale(c, 128); // Overlay: held wedges only
+        leds[i].u = c;
+    }
+}
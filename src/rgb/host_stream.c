@@ -0,0 +1,110 @@
+/**
+ * Host stream - full per-LED frames sent by the host
+ * @author Renard
+ *
+ * The host sends frames on the stream output report (REPORT_ID_STREAM),
+ * split over as many packets as needed. Each packet is
+ *
+ *   [seq, flags, len, tokens[len]]
+ *
+ * seq numbers the frame; flags holds the packet index within the frame
+ * (bits 2..7), RGB_STREAM_KEY (decode over black instead of the previous
+ * frame) and RGB_STREAM_END (last packet). Tokens are delta_codec.c tokens
+ * and continue at the pixel where the previous packet stopped; pixels not
+ * reached by the END packet keep their previous color.
+ *
+ * Core 0 decodes into the back buffer and flips on END, so core 1 only
+ * ever sees complete frames. A packet out of order drops the frame, and
+ * since the next frames are deltas, delta frames are then ignored until
+ * the next keyframe; the host should send one periodically.
+ **/
+
+#define RGB_STREAM_KEY 0x01
+#define RGB_STREAM_END 0x02
+#define RGB_STREAM_HEADER 3
+
+typedef struct
+{
+  RGB_t px[WS2812B_LED_SIZE];
+} rgb_stream_frame_t;
+
+// Two frames; core 0 fills the back one and publishes it by bumping seq
+static rgb_stream_frame_t rgb_stream_buf[2];
+static volatile uint32_t rgb_stream_seq = 0; // Front buffer is seq & 1
+
+// Receiver state (core 0)
+static uint8_t rgb_stream_frame_id = 0; // seq byte of the frame being received
+static uint8_t rgb_stream_packet = 0;   // Next expected packet index
+static uint16_t rgb_stream_px = 0;      // Next pixel to decode
+static bool rgb_stream_receiving = false;
+static bool rgb_stream_need_key = true; // Back buffer has no valid base
+static uint32_t rgb_stream_dropped = 0; // Frames dropped, for GET_STREAM_STATUS
+
+/**
+ * Handle one stream packet (core 0, from the HID output report callback)
+ **/
+static void rgb_stream_receive(const uint8_t *buf, uint16_t len)
+{
+  if (len < RGB_STREAM_HEADER)
+    return;
+  uint8_t frame_id = buf[0], flags = buf[1], n = buf[2];
+  uint8_t packet = flags >> 2;
+  rgb_stream_frame_t *back = &rgb_stream_buf[(rgb_stream_seq + 1) & 1u];
+
+  if (packet == 0)
+  {
+    if (rgb_stream_receiving)
+      rgb_stream_dropped++; // Previous frame never finished
+    rgb_stream_receiving = false;
+    if (flags & RGB_STREAM_KEY)
+      memset(back, 0, sizeof(*back));
+    else if (rgb_stream_need_key)
+      return;
+    else
+      *back = rgb_stream_buf[rgb_stream_seq & 1u];
+    rgb_stream_frame_id = frame_id;
+    rgb_stream_packet = 0;
+    rgb_stream_px = 0;
+    rgb_stream_receiving = true;
+  }
+  if (!rgb_stream_receiving)
+    return;
+  if (frame_id != rgb_stream_frame_id || packet != rgb_stream_packet || n > len - RGB_STREAM_HEADER ||
+      rgb_delta_decode(back->px, &rgb_stream_px, WS2812B_LED_SIZE, &buf[RGB_STREAM_HEADER], n) != n)
+  {
+    // Lost sync: the back buffer no longer matches what the host diffs against
+    rgb_stream_receiving = false;
+    rgb_stream_need_key = true;
+    rgb_stream_dropped++;
+    return;
+  }
+  rgb_stream_packet++;
+  if (flags & RGB_STREAM_END)
+  {
+    rgb_stream_receiving = false;
+    rgb_stream_need_key = false;
+    __dmb(); // Frame is complete before it is published
+    rgb_stream_seq++;
+    rgb_doorbell_ring(RGB_WAKE_UPDATE);
+  }
+}
+
+/**
+ * Host Stream effect - shows the last complete streamed frame; black until one arrives
+ **/
+void ws_host_stream(void *ctx, const rgb_frame_t *frame)
+{
+  (void)ctx;
+  (void)frame;
+  uint32_t seq;
+  do
+  {
+    seq = rgb_stream_seq;
+    __dmb();
+    if (seq == 0)
+      memset(leds, 0, sizeof(leds));
+    else
+      memcpy(leds, rgb_stream_buf[seq & 1u].px, sizeof(leds));
+    __dmb();
+  } while (seq != rgb_stream_seq); // Core 0 reused this buffer mid-copy
+}
@@ -0,0 +1,283 @@
+/**
+ * Input snapshot channel - core 0 publishes, core 1 consumes
+ * @author Renard
+ *
+ * Core 0 publishes buttons and encoder positions once per main loop into a
+ * seqlock-protected sample; core 1 copies one consistent sample per frame
+ * and turns it into per-frame deltas and press edges (rgb_input_t) that all
+ * layers share. Neither side blocks: the writer never waits, and the reader
+ * only retries if it raced a publish.
+ *
+ * Presses are counted rather than sampled, so a tap that starts and ends
+ * between two frames still reaches the effects.
+ *
+ * Core 0 rings a doorbell through the inter-core FIFO whenever something
+ * that can change the output happens. RGB_WAKE_UPDATE (input, HID colors,
+ * config) ends the idle sleep used while every visible layer is static
+ * (EFFECT_FLAG_STATIC) and is coalesced to one message per frame;
+ * RGB_WAKE_EDGE (button pressed or released) also cuts the wait for the
+ * next render tick short, so reactive lighting does not wait up to a frame.
+ *
+ * The same FIFO parks core 1 while core 0 writes flash: RGB_WAKE_PARK
+ * makes core 1 finish its frame and spin in RAM with interrupts off until
+ * released, so nothing executes from XIP during an erase or program. The
+ * SDK's multicore_lockout is not used because its FIFO interrupt would
+ * swallow the doorbell messages.
+ **/
+
+typedef struct
+{
+  uint64_t time_us;                // When core 0 sampled the inputs
+  uint32_t enc[ENC_GPIO_SIZE];     // Raw encoder positions (direction not applied)
+  uint32_t enc_pulse;              // Steps per turn (active profile)
+  uint8_t enc_rev;                 // Bit per reversed encoder (active profile)
+  uint64_t edge_us;                // When core 0 last saw a button change
+  uint16_t buttons;                // Debounced held state
+  uint8_t presses[SW_GPIO_SIZE];   // Rising edges per button, wrapping
+} rgb_input_sample_t;
+
+// Seqlock: odd while core 0 is writing
+static volatile uint32_t rgb_input_seq = 0;
+static rgb_input_sample_t rgb_input_sample;
+
+// Doorbell messages
+#define RGB_WAKE_UPDATE 0u // Output may have changed; render at the next tick
+#define RGB_WAKE_EDGE 1u   // Button edge; render now
+#define RGB_WAKE_PARK 2u   // Flash write ahead; park in RAM (see rgb_park_request())
+
+// An UPDATE is in the FIFO or was consumed this frame; cleared by core 1
+static volatile bool rgb_wake_pending = false;
+
+/**
+ * Wake core 1 (core 0). Never blocks; UPDATEs are coalesced so edges
+ * always find room in the FIFO.
+ * @param kind RGB_WAKE_UPDATE or RGB_WAKE_EDGE
+ **/
+static inline void rgb_doorbell_ring(uint32_t kind)
+{
+  __dmb(); // State the wake refers to is visible before the flag is read
+  if (kind == RGB_WAKE_UPDATE)
+  {
+    if (rgb_wake_pending)
+      return;
+    rgb_wake_pending = true;
+  }
+  if (multicore_fifo_wready())
+    multicore_fifo_push_blocking(kind);
+}
+
+// Flash parking: requested and released by core 0, acknowledged by core 1
+static volatile bool rgb_core1_running = false; // Set before core 1 is launched
+static volatile bool rgb_park_req = false;
+static volatile bool rgb_park_ack = false;
+
+/**
+ * Ask core 1 to park (core 0). Never blocks; poll rgb_park_acked().
+ **/
+static void rgb_park_request(void)
+{
+  rgb_park_req = true;
+  __dmb();
+  if (rgb_core1_running && multicore_fifo_wready())
+    multicore_fifo_push_blocking(RGB_WAKE_PARK); // Full FIFO: core 1 sees the flag when it drains it
+}
+
+/**
+ * Whether flash may be written: core 1 is parked or not running (core 0)
+ **/
+static inline bool rgb_park_acked(void)
+{
+  return !rgb_core1_running || rgb_park_ack;
+}
+
+/**
+ * Let core 1 run again (core 0); returns once it has left the park loop,
+ * so a new request cannot see a stale acknowledgement
+ **/
+static void rgb_park_release(void)
+{
+  rgb_park_req = false;
+  __dmb();
+  while (rgb_core1_running && rgb_park_ack)
+    tight_loop_contents();
+}
+
+/**
+ * Park loop (core 1): runs from RAM with interrupts off while core 0
+ * owns the flash
+ **/
+static void __not_in_flash_func(rgb_core1_park)(void)
+{
+  uint32_t ints = save_and_disable_interrupts();
+  rgb_park_ack = true;
+  __dmb();
+  while (rgb_park_req)
+    tight_loop_contents();
+  rgb_park_ack = false;
+  __dmb();
+  restore_interrupts(ints);
+}
+
+static inline void rgb_park_check(void)
+{
+  if (rgb_park_req)
+    rgb_core1_park();
+}
+
+/**
+ * Discard pending wakes before rendering (core 1); anything rung after
+ * this lands in the FIFO and ends the next wait. Parks first if core 0
+ * asked, since the drain may have swallowed the request.
+ **/
+static inline void rgb_doorbell_clear(void)
+{
+  multicore_fifo_drain();
+  rgb_wake_pending = false;
+  __dmb();
+  rgb_park_check();
+}
+
+/**
+ * Sleep until a deadline, ending early only on a button edge (core 1).
+ * Park requests are served in place and the wait goes on.
+ * @param any_wake Also end on RGB_WAKE_UPDATE
+ * @return true if woken by a button edge
+ **/
+static bool rgb_doorbell_wait_until_msg(absolute_time_t deadline, bool any_wake)
+{
+  uint32_t msg;
+  int64_t left;
+  while ((left = absolute_time_diff_us(get_absolute_time(), deadline)) > 0)
+  {
+    if (!multicore_fifo_pop_timeout_us((uint64_t)left, &msg))
+      break;
+    rgb_park_check(); // Also catches a request that found the FIFO full
+    if (msg == RGB_WAKE_EDGE)
+      return true;
+    if (msg == RGB_WAKE_UPDATE && any_wake)
+      return false;
+  }
+  return false;
+}
+
+/**
+ * Sleep until core 0 rings or the timeout passes (core 1)
+ * @return true if woken by a button edge
+ **/
+static inline bool rgb_doorbell_wait(uint64_t timeout_us)
+{
+  return rgb_doorbell_wait_until_msg(make_timeout_time_us(timeout_us), true);
+}
+
+/**
+ * Sleep until a deadline, ending early only on a button edge (core 1)
+ * @return true if woken by a button edge
+ **/
+static inline bool rgb_doorbell_wait_until(absolute_time_t deadline)
+{
+  return rgb_doorbell_wait_until_msg(deadline, false);
+}
+
+/**
+ * Publish the current inputs (core 0, once per main loop)
+ * @param buttons Debounced button bitmask
+ * @param enc_rev Active profile's reversed encoders, bit per encoder
+ * @param enc_pulse Active profile's steps per turn
+ **/
+static void rgb_input_publish(uint16_t buttons, uint8_t enc_rev, uint32_t enc_pulse)
+{
+  static uint16_t prev_buttons = 0;
+  uint16_t pressed = buttons & ~prev_buttons;
+  bool edge = buttons != prev_buttons;
+  bool changed = edge;
+  prev_buttons = buttons;
+  for (int i = 0; i < ENC_GPIO_SIZE; i++)
+    changed |= rgb_input_sample.enc[i] != enc_val[i];
+
+  rgb_input_seq++;
+  __dmb();
+  rgb_input_sample.time_us = time_us_64();
+  if (edge)
+    rgb_input_sample.edge_us = rgb_input_sample.time_us;
+  for (int i = 0; i < ENC_GPIO_SIZE; i++)
+    rgb_input_sample.enc[i] = enc_val[i]; // Word reads; DMA may update between encoders
+  rgb_input_sample.enc_pulse = enc_pulse;
+  rgb_input_sample.enc_rev = enc_rev;
+  rgb_input_sample.buttons = buttons;
+  for (int i = 0; i < SW_GPIO_SIZE; i++)
+    if (pressed & (1u << i))
+      rgb_input_sample.presses[i]++;
+  __dmb();
+  rgb_input_seq++;
+  if (changed)
+    rgb_doorbell_ring(edge ? RGB_WAKE_EDGE : RGB_WAKE_UPDATE);
+}
+
+/**
+ * Copy the latest published sample (core 1)
+ **/
+static void rgb_input_copy(rgb_input_sample_t *out)
+{
+  uint32_t seq;
+  do
+  {
+    while ((seq = rgb_input_seq) & 1u)
+      tight_loop_contents();
+    __dmb();
+    memcpy(out, &rgb_input_sample, sizeof(*out));
+    __dmb();
+  } while (seq != rgb_input_seq);
+}
+
+// Per-frame input handed to every layer via rgb_frame_t
+typedef struct
+{
+  uint64_t time_us;                // Sample time of this snapshot
+  uint64_t edge_us;                // Sample time of the latest button change
+  uint32_t enc[ENC_GPIO_SIZE];     // Encoder positions, wrapping; take them modulo enc_pulse
+  int32_t enc_delta[ENC_GPIO_SIZE]; // Steps since the previous frame
+  uint32_t enc_pulse;              // Steps per turn (active profile's PPR x 4)
+  uint16_t buttons;                // Held
+  uint16_t pressed;                // Pressed at least once since the previous frame
+  uint16_t released;               // Held last frame, not held now
+} rgb_input_t;
+
+// Core 1 state for turning samples into per-frame deltas
+typedef struct
+{
+  rgb_input_sample_t prev;
+  bool primed;
+} rgb_input_reader_t;
+
+/**
+ * Take one consistent snapshot and derive this frame's deltas (core 1)
+ **/
+static void rgb_input_read(rgb_input_reader_t *r, rgb_input_t *in)
+{
+  rgb_input_sample_t s;
+  rgb_input_copy(&s);
+  if (!r->primed)
+  {
+    r->prev = s; // First frame: no motion, no edges
+    r->primed = true;
+  }
+  in->time_us = s.time_us;
+  in->edge_us = s.edge_us;
+  // Encoders the active profile reverses count the other way; the mirror is
+  // taken within one turn, as enc_pulse need not divide 2^32
+  in->enc_pulse = s.enc_pulse ? s.enc_pulse : 1;
+  for (int i = 0; i < ENC_GPIO_SIZE; i++)
+  {
+    bool rev = (s.enc_rev >> i) & 1u;
+    int32_t d = (int32_t)(s.enc[i] - r->prev.enc[i]);
+    in->enc[i] = rev ? (in->enc_pulse - s.enc[i] % in->enc_pulse) % in->enc_pulse : s.enc[i];
+    in->enc_delta[i] = rev ? -d : d;
+  }
+  in->buttons = s.buttons;
+  in->pressed = 0;
+  for (int i = 0; i < SW_GPIO_SIZE; i++)
+    if (s.presses[i] != r->prev.presses[i])
+      in->pressed |= 1u << i;
+  in->released = r->prev.buttons & ~s.buttons;
+  r->prev = s;
+}
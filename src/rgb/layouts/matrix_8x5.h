@@ -0,0 +1,72 @@
+/**
+ * Example 2D layout: 8x5 serpentine matrix panel (40 LEDs)
+ *
+ * Row 0 is the top, wired left to right; odd rows run right to left. Angles
+ * are measured clockwise from the top around the panel center, so ring
+ * effects sweep around the panel. The left half is zone 0, the right half
+ * zone 1. Buttons anchor toward the bottom edge.
+ *
+ * Use with WS2812B_LED_SIZE 40, SW_GPIO_SIZE 10 and
+ *   #define LED_LAYOUT_MAP "layouts/matrix_8x5.h"
+ **/
+
+_Static_assert(WS2812B_LED_SIZE == 40, "matrix_8x5 layout expects 40 LEDs");
+_Static_assert(SW_GPIO_SIZE == 10, "matrix_8x5 layout expects 10 buttons");
+
+#define LED_TRACK_LEN 40
+
+static const led_layout_t led_layout_map[WS2812B_LED_SIZE] = {
+    {.angle = 57344, .x = -127, .y = -127, .zone = 0, .track = 0},
+    {.angle = 59051, .x = -91, .y = -127, .zone = 0, .track = 1},
+    {.angle = 61343, .x = -54, .y = -127, .zone = 0, .track = 2},
+    {.angle = 64067, .x = -18, .y = -127, .zone = 0, .track = 3},
+    {.angle = 1469, .x = 18, .y = -127, .zone = 1, .track = 4},
+    {.angle = 4193, .x = 54, .y = -127, .zone = 1, .track = 5},
+    {.angle = 6485, .x = 91, .y = -127, .zone = 1, .track = 6},
+    {.angle = 8192, .x = 127, .y = -127, .zone = 1, .track = 7},
+    {.angle = 11515, .x = 127, .y = -64, .zone = 1, .track = 8},
+    {.angle = 9991, .x = 91, .y = -64, .zone = 1, .track = 9},
+    {.angle = 7310, .x = 54, .y = -64, .zone = 1, .track = 10},
+    {.angle = 2860, .x = 18, .y = -64, .zone = 1, .track = 11},
+    {.angle = 62676, .x = -18, .y = -64, .zone = 0, .track = 12},
+    {.angle = 58226, .x = -54, .y = -64, .zone = 0, .track = 13},
+    {.angle = 55545, .x = -91, .y = -64, .zone = 0, .track = 14},
+    {.angle = 54021, .x = -127, .y = -64, .zone = 0, .track = 15},
+    {.angle = 49152, .x = -127, .y = 0, .zone = 0, .track = 16},
+    {.angle = 49152, .x = -91, .y = 0, .zone = 0, .track = 17},
+    {.angle = 49152, .x = -54, .y = 0, .zone = 0, .track = 18},
+    {.angle = 49152, .x = -18, .y = 0, .zone = 0, .track = 19},
+    {.angle = 16384, .x = 18, .y = 0, .zone = 1, .track = 20},
+    {.angle = 16384, .x = 54, .y = 0, .zone = 1, .track = 21},
+    {.angle = 16384, .x = 91, .y = 0, .zone = 1, .track = 22},
+    {.angle = 16384, .x = 127, .y = 0, .zone = 1, .track = 23},
+    {.angle = 21253, .x = 127, .y = 64, .zone = 1, .track = 24},
+    {.angle = 22777, .x = 91, .y = 64, .zone = 1, .track = 25},
+    {.angle = 25458, .x = 54, .y = 64, .zone = 1, .track = 26},
+    {.angle = 29908, .x = 18, .y = 64, .zone = 1, .track = 27},
+    {.angle = 35628, .x = -18, .y = 64, .zone = 0, .track = 28},
+    {.angle = 40078, .x = -54, .y = 64, .zone = 0, .track = 29},
+    {.angle = 42759, .x = -91, .y = 64, .zone = 0, .track = 30},
+    {.angle = 44283, .x = -127, .y = 64, .zone = 0, .track = 31},
+    {.angle = 40960, .x = -127, .y = 127, .zone = 0, .track = 32},
+    {.angle = 39253, .x = -91, .y = 127, .zone = 0, .track = 33},
+    {.angle = 36961, .x = -54, .y = 127, .zone = 0, .track = 34},
+    {.angle = 34237, .x = -18, .y = 127, .zone = 0, .track = 35},
+    {.angle = 31299, .x = 18, .y = 127, .zone = 1, .track = 36},
+    {.angle = 28575, .x = 54, .y = 127, .zone = 1, .track = 37},
+    {.angle = 26283, .x = 91, .y = 127, .zone = 1, .track = 38},
+    {.angle = 24576, .x = 127, .y = 127, .zone = 1, .track = 39},
+};
+
+static const button_anchor_t button_anchor_map[SW_GPIO_SIZE] = {
+    {.angle = 41276, .zone = 0},
+    {.angle = 37862, .zone = 0},
+    {.angle = 32768, .zone = 0},
+    {.angle = 27674, .zone = 1},
+    {.angle = 24260, .zone = 1},
+    {.angle = 39826, .zone = 0},
+    {.angle = 36751, .zone = 0},
+    {.angle = 32768, .zone = 1},
+    {.angle = 28785, .zone = 1},
+    {.angle = 25710, .zone = 1},
+};
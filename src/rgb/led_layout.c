@@ -0,0 +1,116 @@
+/**
+ * LED spatial layout - per-LED geometry and button anchors
+ * @author Renard
+ *
+ * Effects index these tables instead of recomputing geometry from the LED
+ * index. By default the strip is a uniform ring starting at the top and
+ * running clockwise, with buttons spread evenly around it. Point
+ * LED_LAYOUT_MAP (controller_config.h) at a header that defines
+ * led_layout_map[] / button_anchor_map[] / LED_TRACK_LEN to describe any
+ * other arrangement, including 2D panels and matrices (see layouts/).
+ * Maps only need angle, x/y, zone and track per LED and angle/zone per
+ * button; led_layout_init() derives the rest.
+ **/
+#include <math.h>
+
+typedef struct
+{
+  float ring;     // Position around the ring in LED units (0..N), from angle
+  uint16_t angle; // Q16 turn (65536 = 360 deg), clockwise from the top
+  uint16_t wheel; // Palette position 0..767 matching angle
+  int8_t x, y;    // Position in -127..127 (x right, y down)
+  uint8_t zone;   // HID color zone
+  uint8_t button; // Wedge owner: last button anchor at or before this LED
+  uint8_t track;  // Turbocharger track slot (track has gaps where no LEDs sit)
+} led_layout_t;
+
+typedef struct
+{
+  float ring;     // Position around the ring in LED units
+  uint16_t angle; // Q16 turn
+  uint8_t led;    // Nearest LED
+  uint8_t zone;   // HID color zone of this button
+} button_anchor_t;
+
+static led_layout_t led_layout[WS2812B_LED_SIZE];
+static button_anchor_t button_anchor[SW_GPIO_SIZE];
+static uint8_t led_track_len; // Track slots, including gaps
+
+#ifdef LED_LAYOUT_MAP
+#include LED_LAYOUT_MAP
+#endif
+
+/**
+ * Unsigned clockwise distance between two Q16 angles
+ **/
+static inline uint16_t angle_fwd(uint16_t from, uint16_t to)
+{
+  return (uint16_t)(to - from);
+}
+
+/**
+ * Shortest distance between two Q16 angles
+ **/
+static inline uint16_t angle_dist(uint16_t a, uint16_t b)
+{
+  int16_t d = (int16_t)(uint16_t)(a - b);
+  return (uint16_t)(d < 0 ? -d : d);
+}
+
+/**
+ * Build the layout tables (once, before the first frame)
+ **/
+static void led_layout_init(void)
+{
+#ifdef LED_LAYOUT_MAP
+  memcpy(led_layout, led_layout_map, sizeof(led_layout));
+  memcpy(button_anchor, button_anchor_map, sizeof(button_anchor));
+  led_track_len = LED_TRACK_LEN;
+#else
+  // Uniform ring. The turbocharger track leaves 2 empty slots at the top,
+  // 3 at the bottom and 1 after the last LED, matching the physical corners.
+  for (int i = 0; i < WS2812B_LED_SIZE; i++)
+  {
+    led_layout_t *l = &led_layout[i];
+    l->angle = (uint16_t)(((uint32_t)i << 16) / WS2812B_LED_SIZE);
+    float a = l->angle * (6.2831853f / 65536.0f);
+    l->x = (int8_t)lroundf(sinf(a) * 127.0f);
+    l->y = (int8_t)lroundf(-cosf(a) * 127.0f);
+    l->zone = (uint8_t)(i * WS2812B_LED_ZONES / WS2812B_LED_SIZE);
+    l->track = (uint8_t)(2 + i + (i >= WS2812B_LED_SIZE / 2 ? 3 : 0));
+  }
+  for (int b = 0; b < SW_GPIO_SIZE; b++)
+  {
+    button_anchor[b].angle = (uint16_t)(((uint32_t)b << 16) / SW_GPIO_SIZE);
+    button_anchor[b].zone = (uint8_t)(b * WS2812B_LED_ZONES / SW_GPIO_SIZE);
+  }
+  led_track_len = WS2812B_LED_SIZE + 6;
+#endif
+
+  // Derived fields
+  for (int i = 0; i < WS2812B_LED_SIZE; i++)
+  {
+    led_layout_t *l = &led_layout[i];
+    l->ring = l->angle * ((float)WS2812B_LED_SIZE / 65536.0f);
+    l->wheel = (uint16_t)((l->angle * 768u) >> 16);
+    uint16_t best = UINT16_MAX;
+    for (int b = 0; b < SW_GPIO_SIZE; b++)
+    {
+      uint16_t d = angle_fwd(button_anchor[b].angle, l->angle);
+      if (d < best)
+        best = d, l->button = (uint8_t)b;
+    }
+  }
+  for (int b = 0; b < SW_GPIO_SIZE; b++)
+  {
+    button_anchor_t *a = &button_anchor[b];
+    a->ring = a->angle * ((float)WS2812B_LED_SIZE / 65536.0f);
+    uint16_t best = UINT16_MAX;
+    for (int i = 0; i < WS2812B_LED_SIZE; i++)
+    {
+      uint16_t d = angle_dist(led_layout[i].angle, a->angle);
+      if (d < best)
+        best = d, a->led = (uint8_t)i;
+    }
+  }
+}
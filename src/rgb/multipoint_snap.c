@@ -1,12 +1,21 @@
 /** Multi-point chase that snaps to button angles and recolors **/
 #include <math.h>
-void ws_multipoint_snap(uint32_t counter, bool hid_mode)
-{
 #define PTS 4
-    static float pts[PTS] = {0};
-    static uint8_t hueShift = 0;
+typedef struct
+{
+    float pts[PTS];
+    uint8_t hueShift;
+} multipoint_snap_ctx_t;
+
+void ws_multipoint_snap(void *ctx, const rgb_frame_t *frame)
+{
+    multipoint_snap_ctx_t *c = ctx;
+    float *pts = c->pts;
 
-    float pos = ((enc_val[0] % ENC_PULSE) / (float)ENC_PULSE) * WS2812B_LED_SIZE;
+    uint32_t pulse = frame->input.enc_pulse;
+    float pos = ((frame->input.enc[0] % pulse) / (float)pulse) * WS2812B_LED_SIZE;
+    // Points close 20% of the gap per 5 ms tick
+    float follow = 1.0f - powf(0.8f, rgb_ticks(frame->dt_ms));
     for (int k = 0; k < PTS; ++k)
     {
         float target = fmodf(pos + (k * WS2812B_LED_SIZE / PTS), WS2812B_LED_SIZE);
@@ -15,42 +24,38 @@ void ws_multipoint_snap(uint32_t counter, bool hid_mode)
             diff -= WS2812B_LED_SIZE;
         if (diff < -WS2812B_LED_SIZE / 2)
             diff += WS2812B_LED_SIZE;
-        pts[k] = fmodf(pts[k] + diff * 0.2f, WS2812B_LED_SIZE);
+        pts[k] = fmodf(pts[k] + diff * follow, WS2812B_LED_SIZE);
         if (pts[k] < 0)
             pts[k] += WS2812B_LED_SIZE;
     }
 
     // snap on button events
-    static uint16_t last = 0;
-    uint16_t now = g_buttons;
-    uint16_t press = (~last) & now;
-    last = now;
+    uint16_t press = frame->input.pressed;
     if (press)
     {
         int bi = __builtin_ctz(press);
-        float ang = (bi * WS2812B_LED_SIZE) / (float)SW_GPIO_SIZE;
+        float ang = button_anchor[bi].ring;
         pts[bi % PTS] = ang;
-        hueShift += 16;
+        c->hueShift += 16;
     }
 
-    set_color_palette(PALETTE_VIRIDIS);
     for (int i = 0; i < WS2812B_LED_SIZE; ++i)
     {
-        uint32_t base = color_wheel((i * 768 / WS2812B_LED_SIZE + counter / 8 + hueShift) % 768);
+        uint32_t base = background_wheel(frame, (led_layout[i].wheel + frame->time_ms / 40 + c->hueShift) % 768);
         float r = ((base >> 8) & 0xFF) * 0.15f;
         float g = ((base >> 16) & 0xFF) * 0.15f;
         float b = (base & 0xFF) * 0.15f;
         for (int k = 0; k < PTS; ++k)
         {
-            float d = fabsf(pts[k] - i);
+            float d = fabsf(pts[k] - led_layout[i].ring);
             if (d > WS2812B_LED_SIZE - d)
                 d = WS2812B_LED_SIZE - d;
-            float w = expf(-d * 0.9f);
+            float w = expf(-d * frame->params->falloff);
             r += w * hid_rgb[k & 1].r;
             g += w * hid_rgb[k & 1].g;
             b += w * hid_rgb[k & 1].b;
         }
-        float s = hid_mode ? 0.75f : 1.0f;
+        float s = frame->hid_mode ? 0.75f : 1.0f;
         leds[i].r = (uint8_t)fminf(255.0f, s * r);
         leds[i].g = (uint8_t)fminf(255.0f, s * g);
         leds[i].b = (uint8_t)fminf(255.0f, s * b);
@@ -0,0 +1,201 @@
+/**
+ * Particle engine shared by the trail, comet, ripple and radar effects
+ * @author Renard
+ *
+ * Particles live on the strip as a ring: position is a Q32 fraction of a
+ * turn, so it wraps for free, and velocity is in the same unit per ms.
+ * Everything per frame is integer: rgb_particles_step() moves particles and
+ * ages them out, and drawing splats each one onto the LEDs around it
+ * through a precomputed falloff kernel, costing O(particles x kernel width)
+ * instead of O(LEDs x particles).
+ *
+ * The ring is the strip in index order (LED i sits at i/N of a turn), as
+ * the trail and comet effects always drew it; place particles at an LED
+ * with rgb_led_turn(), e.g. rgb_led_turn(button_anchor[b].led).
+ *
+ * Pools are plain arrays inside an effect's context; a free slot has
+ * life_ms == 0. rgb_particle_spawn() reuses the oldest particle when the
+ * pool is full, so new events always show.
+ **/
+
+#define RGB_PARTICLES_MAX 32                           // Largest pool an effect context holds
+#define RGB_PARTICLE_POOL_BYTES (RGB_PARTICLES_MAX * 20) // Reserved in RGB_EFFECT_CTX_MAX
+
+#define RGB_PARTICLE_IMMORTAL 0xFFFF // life_ms that never counts down
+
+// Falloff kernels (weight by distance from the particle)
+#define RGB_KERNEL_NARROW 0 // Anti-aliased point, 1 LED radius
+#define RGB_KERNEL_GLOW 1   // Bright core with a ~70% halo on the neighbors
+#define RGB_KERNEL_SOFT 2   // exp(-0.9 d), 4 LED radius
+#define RGB_KERNEL_COUNT 3
+
+#define RGB_PARTICLE_KERNEL_MASK 0x03 // flags: RGB_KERNEL_*
+
+#define RGB_KERNEL_RADIUS 4                 // LEDs, widest kernel
+#define RGB_KERNEL_STEPS_PER_LED 16         // Table resolution
+#define RGB_KERNEL_STEPS (RGB_KERNEL_RADIUS * RGB_KERNEL_STEPS_PER_LED + 1)
+
+typedef struct
+{
+  uint32_t pos;     // Q32 turn around the strip
+  int32_t vel;      // Q32 turns per ms
+  uint32_t color;   // Packed RGB_t at full level (draw only)
+  uint16_t life_ms; // Remaining life; 0 = free slot
+  uint8_t level;    // Intensity 0..255
+  uint8_t flags;    // RGB_KERNEL_*
+  uint8_t tag;      // Effect-defined (e.g. HID zone)
+  uint8_t fade;     // Fade out over the last fade * 4 ms of life, 0 = none
+} rgb_particle_t;
+_Static_assert(sizeof(rgb_particle_t) * RGB_PARTICLES_MAX <= RGB_PARTICLE_POOL_BYTES, "particle pool exceeds its reserve");
+
+static const uint8_t rgb_kernel_radius[RGB_KERNEL_COUNT] = {1, 2, 4};
+static uint16_t rgb_kernel[RGB_KERNEL_COUNT][RGB_KERNEL_STEPS]; // Weight 0..256
+
+/**
+ * Build the kernel tables (once, before the first frame)
+ **/
+static void rgb_particles_init(void)
+{
+  for (int s = 0; s < RGB_KERNEL_STEPS; ++s)
+  {
+    float d = (float)s / RGB_KERNEL_STEPS_PER_LED;
+    float narrow = d < 1.0f ? 1.0f - d : 0.0f;
+    float glow = d < 1.0f ? 1.0f - 0.3f * d : d < 2.0f ? 0.7f * (2.0f - d) : 0.0f;
+    float soft = expf(-0.9f * d);
+    rgb_kernel[RGB_KERNEL_NARROW][s] = (uint16_t)lroundf(narrow * 256.0f);
+    rgb_kernel[RGB_KERNEL_GLOW][s] = (uint16_t)lroundf(glow * 256.0f);
+    rgb_kernel[RGB_KERNEL_SOFT][s] = (uint16_t)lroundf(soft * 256.0f);
+  }
+}
+
+/**
+ * Convert a distance in LEDs (Q16.16) to Q32 turns
+ **/
+static inline int32_t rgb_leds_to_turn(int32_t leds_q16)
+{
+  return (int32_t)(((int64_t)leds_q16 << 16) / WS2812B_LED_SIZE);
+}
+
+/**
+ * Position of an LED in Q32 turns
+ **/
+static inline uint32_t rgb_led_turn(int led)
+{
+  return (uint32_t)(((uint64_t)led << 32) / WS2812B_LED_SIZE);
+}
+
+/**
+ * Free slot in a pool, or the particle closest to dying if it is full
+ **/
+static rgb_particle_t *rgb_particle_spawn(rgb_particle_t *pool, int n)
+{
+  rgb_particle_t *oldest = &pool[0];
+  for (int i = 0; i < n; ++i)
+  {
+    if (!pool[i].life_ms)
+      return &pool[i];
+    if (pool[i].life_ms < oldest->life_ms)
+      oldest = &pool[i];
+  }
+  return oldest;
+}
+
+/**
+ * Move and age every live particle
+ **/
+static void rgb_particles_step(rgb_particle_t *pool, int n, uint32_t dt_ms)
+{
+  for (int i = 0; i < n; ++i)
+  {
+    rgb_particle_t *p = &pool[i];
+    if (!p->life_ms)
+      continue;
+    p->pos += (uint32_t)p->vel * dt_ms; // Wraps around the ring
+    if (p->life_ms != RGB_PARTICLE_IMMORTAL)
+      p->life_ms = dt_ms >= p->life_ms ? 0 : (uint16_t)(p->life_ms - dt_ms);
+  }
+}
+
+/**
+ * Intensity after the fade-out, 0..256
+ **/
+static inline uint32_t rgb_particle_level(const rgb_particle_t *p)
+{
+  uint32_t level = rgb_weight(p->level);
+  uint32_t window = p->fade * 4u;
+  if (p->life_ms < window)
+    level = level * p->life_ms / window;
+  return level;
+}
+
+#define RGB_FOOTPRINT_MAX (2 * RGB_KERNEL_RADIUS + 2)
+
+/**
+ * LEDs under a particle's kernel
+ * @param level Particle intensity, 0..256
+ * @param led Out: LED indices
+ * @param w Out: weights, 0..256
+ * @return Number of LEDs
+ **/
+static int rgb_particle_footprint(const rgb_particle_t *p, uint32_t level, uint8_t *led, uint16_t *w)
+{
+  uint32_t lp = ((p->pos >> 16) * WS2812B_LED_SIZE) >> 8; // Q8 LED units
+  int c = (int)(lp >> 8), f = (int)(lp & 0xFF);
+  int k = p->flags & RGB_PARTICLE_KERNEL_MASK, r = rgb_kernel_radius[k];
+  int n = 0;
+  for (int o = -r; o <= r + 1; ++o)
+  {
+    int d = o * 256 - f;
+    d = (d < 0 ? -d : d) / (256 / RGB_KERNEL_STEPS_PER_LED);
+    if (d >= RGB_KERNEL_STEPS)
+      continue;
+    uint32_t wt = rgb_kernel[k][d] * level >> 8;
+    if (!wt)
+      continue;
+    led[n] = (uint8_t)((c + o + WS2812B_LED_SIZE) % WS2812B_LED_SIZE);
+    w[n++] = (uint16_t)wt;
+  }
+  return n;
+}
+
+/**
+ * Splat particles additively, in their own colors
+ * @param scale Overall weight, 0..256
+ **/
+static void rgb_particles_draw(const rgb_particle_t *pool, int n, RGB_t *dst, uint32_t scale)
+{
+  uint8_t led[RGB_FOOTPRINT_MAX];
+  uint16_t w[RGB_FOOTPRINT_MAX];
+  for (int i = 0; i < n; ++i)
+  {
+    const rgb_particle_t *p = &pool[i];
+    if (!p->life_ms)
+      continue;
+    int m = rgb_particle_footprint(p, rgb_particle_level(p) * scale >> 8, led, w);
+    for (int j = 0; j < m; ++j)
+      dst[led[j]].u = rgb_px_add_sat(dst[led[j]].u, rgb_px_scale(p->color, w[j]));
+  }
+}
+
+/**
+ * Stamp particles into a level buffer, keeping the brighter value; effects
+ * with persistent trails decay the buffer themselves
+ **/
+static void rgb_particles_stamp(const rgb_particle_t *pool, int n, rgb_levels_t *lv)
+{
+  uint8_t led[RGB_FOOTPRINT_MAX];
+  uint16_t w[RGB_FOOTPRINT_MAX];
+  for (int i = 0; i < n; ++i)
+  {
+    const rgb_particle_t *p = &pool[i];
+    if (!p->life_ms)
+      continue;
+    int m = rgb_particle_footprint(p, rgb_particle_level(p), led, w);
+    for (int j = 0; j < m; ++j)
+    {
+      uint8_t v = (uint8_t)(w[j] > 255 ? 255 : w[j]);
+      if (lv->v[led[j]] < v)
+        lv->v[led[j]] = v;
+    }
+  }
+}
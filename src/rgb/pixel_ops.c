@@ -0,0 +1,125 @@
+/**
+ * Packed-pixel kernels (SIMD within a register)
+ * @author Renard
+ *
+ * RGB_t overlays r, g, b and a pad byte on one uint32_t, so a whole pixel is
+ * a single word. The M0+ has no SIMD unit, but splitting a word into two
+ * 16-bit lanes (r/b and g/pad) lets one 32-bit multiply scale two channels
+ * at once, and byte-wise carry tricks give saturating add/subtract on four
+ * bytes per operation - no per-channel divides.
+ *
+ * Weights are 0..256 (256 = identity); use rgb_weight() to map 0..255.
+ **/
+
+#define RGB_LANES 0x00FF00FFu // r/b lanes (or g/pad after >> 8)
+#define RGB_MSBS 0x80808080u
+#define RGB_LSB7 0x7F7F7F7Fu
+
+/**
+ * Map an 8-bit level to a 0..256 weight, so 255 means full scale
+ **/
+static inline uint32_t rgb_weight(uint8_t level)
+{
+  return level + (level >> 7);
+}
+
+/**
+ * Pack channels into the RGB_t word layout
+ **/
+static inline uint32_t rgb_pack(uint8_t r, uint8_t g, uint8_t b)
+{
+  RGB_t p = {.r = r, .g = g, .b = b};
+  return p.u;
+}
+
+/**
+ * Convert a palette color (urgb_u32 GRB order) into the RGB_t word layout
+ **/
+static inline uint32_t rgb_from_urgb(uint32_t c)
+{
+  return rgb_pack((c >> 8) & 0xFF, (c >> 16) & 0xFF, c & 0xFF);
+}
+
+/**
+ * Scale all channels of a packed pixel
+ * @param p Packed pixel
+ * @param s Weight 0..256
+ **/
+static inline uint32_t rgb_px_scale(uint32_t p, uint32_t s)
+{
+  uint32_t rb = (((p & RGB_LANES) * s) >> 8) & RGB_LANES;
+  uint32_t g = (((p >> 8) & RGB_LANES) * s) & ~RGB_LANES;
+  return rb | g;
+}
+
+/**
+ * Linear blend a -> b of packed pixels
+ * @param t Weight of b, 0..256
+ **/
+static inline uint32_t rgb_px_lerp(uint32_t a, uint32_t b, uint32_t t)
+{
+  uint32_t it = 256 - t;
+  uint32_t rb = (((a & RGB_LANES) * it + (b & RGB_LANES) * t) >> 8) & RGB_LANES;
+  uint32_t g = (((a >> 8) & RGB_LANES) * it + ((b >> 8) & RGB_LANES) * t) & ~RGB_LANES;
+  return rb | g;
+}
+
+/**
+ * Per-byte saturating add of four packed bytes
+ **/
+static inline uint32_t rgb_px_add_sat(uint32_t a, uint32_t b)
+{
+  uint32_t s = (a & RGB_LSB7) + (b & RGB_LSB7);
+  uint32_t carry = ((a & b) | ((a ^ b) & s)) & RGB_MSBS;
+  return (s ^ ((a ^ b) & RGB_MSBS)) | ((carry >> 7) * 0xFF);
+}
+
+/**
+ * Per-byte saturating subtract of four packed bytes (a - b, floored at 0)
+ **/
+static inline uint32_t rgb_px_sub_sat(uint32_t a, uint32_t b)
+{
+  uint32_t d = ((a | RGB_MSBS) - (b & RGB_LSB7)) ^ ((a ^ ~b) & RGB_MSBS);
+  uint32_t borrow = ((~a & b) | (~(a ^ b) & d)) & RGB_MSBS;
+  return d & ~((borrow >> 7) * 0xFF);
+}
+
+/**
+ * Per-byte maximum of four packed bytes
+ **/
+static inline uint32_t rgb_px_max(uint32_t a, uint32_t b)
+{
+  return b + rgb_px_sub_sat(a, b); // never carries: result <= 255 per byte
+}
+
+/**
+ * 8-bit level buffer (trail/decay state) addressable a word at a time
+ **/
+typedef union
+{
+  uint8_t v[WS2812B_LED_SIZE];
+  uint32_t w[(WS2812B_LED_SIZE + 3) / 4];
+} rgb_levels_t;
+
+/**
+ * Subtract a constant from every level, floored at 0, four levels per step
+ * @param amount Decay this frame (clamped to 255)
+ **/
+static inline void rgb_levels_decay(rgb_levels_t *lv, int amount)
+{
+  if (amount <= 0)
+    return;
+  uint32_t sub = (uint32_t)(amount > 255 ? 255 : amount) * 0x01010101u;
+  for (size_t i = 0; i < sizeof(lv->w) / sizeof(lv->w[0]); ++i)
+    lv->w[i] = rgb_px_sub_sat(lv->w[i], sub);
+}
+
+/**
+ * Blend a frame toward another: dst[i] = lerp(from[i], dst[i], t)
+ * @param t Weight of dst, 0..256
+ **/
+static inline void rgb_frame_lerp(RGB_t *dst, const RGB_t *from, int n, uint32_t t)
+{
+  for (int i = 0; i < n; ++i)
+    dst[i].u = rgb_px_lerp(from[i].u, dst[i].u, t);
+}
@@ -1,39 +1,32 @@
 /** Radar sweep with persistent decay **/
-#include <math.h>
-void ws_radar_sweep(uint32_t counter, bool hid_mode)
+typedef struct
 {
-    static uint8_t buf[WS2812B_LED_SIZE] = {0};
-    static float pos = 0.0f;
-    // speed from encoder
-    static uint32_t prev = 0;
-    int d = (int)(enc_val[0] - prev);
-    prev = enc_val[0];
-    float v = (float)d / ENC_PULSE * 4.0f; // adjust speed
-    pos += v;
-    if (pos < 0)
-        pos += WS2812B_LED_SIZE;
-    if (pos >= WS2812B_LED_SIZE)
-        pos -= WS2812B_LED_SIZE;
+    rgb_particle_t head;
+    uint32_t decay_acc;
+    rgb_levels_t buf;
+} radar_sweep_ctx_t;
+_Static_assert(sizeof(radar_sweep_ctx_t) <= RGB_EFFECT_CTX_MAX, "radar_sweep_ctx_t exceeds arena slot");
 
-    int head = (int)pos;
-    buf[head] = 255;
+void ws_radar_sweep(void *ctx, const rgb_frame_t *frame)
+{
+    radar_sweep_ctx_t *c = ctx;
+    uint8_t *buf = c->buf.v;
+    if (!c->head.life_ms)
+        c->head = (rgb_particle_t){.life_ms = RGB_PARTICLE_IMMORTAL, .level = 255, .flags = RGB_KERNEL_NARROW};
+    // speed from encoder: 4 LEDs per encoder turn
+    int d = frame->input.enc_delta[0];
+    c->head.pos += (uint32_t)rgb_leds_to_turn((int32_t)((int64_t)d * 4 * 65536 / frame->input.enc_pulse));
 
-    // decay
-    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
-        buf[i] = buf[i] > 2 ? buf[i] - 2 : 0;
+    // decay (2 per 5 ms tick by default), then light the beam; it spreads over two LEDs between positions
+    rgb_levels_decay(&c->buf, rgb_ticks_scaled(&c->decay_acc, frame->params->decay, frame->dt_ms));
+    rgb_particles_stamp(&c->head, 1, &c->buf);
 
-    set_color_palette(PALETTE_RAINBOW);
+    uint32_t tint = hid_rgb[0].u;
+    uint32_t s = frame->hid_mode ? 205 : 256; // 0.8 once host lights have timed out
     for (int i = 0; i < WS2812B_LED_SIZE; ++i)
     {
-        uint8_t br = buf[i];
-        RGB_t c = hid_rgb[0];
-        uint32_t p = color_wheel((i * 768 / WS2812B_LED_SIZE + counter / 6) % 768);
-        uint8_t pr = ((p >> 8) & 0xFF) / 4;
-        uint8_t pg = ((p >> 16) & 0xFF) / 4;
-        uint8_t pb = (p & 0xFF) / 4;
-        float s = hid_mode ? 0.8f : 1.0f;
-        leds[i].r = (uint8_t)fminf(255.0f, s * (pr + (c.r * br / 255)));
-        leds[i].g = (uint8_t)fminf(255.0f, s * (pg + (c.g * br / 255)));
-        leds[i].b = (uint8_t)fminf(255.0f, s * (pb + (c.b * br / 255)));
+        uint32_t p = rgb_from_urgb(background_wheel(frame, (led_layout[i].wheel + frame->time_ms / 30) % 768));
+        uint32_t px = rgb_px_add_sat(rgb_px_scale(p, 64), rgb_px_scale(tint, rgb_weight(buf[i])));
+        leds[i].u = rgb_px_scale(px, s);
     }
 }
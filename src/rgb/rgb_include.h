@@ -2,31 +2,62 @@
  * Simple header file to include all files in the folder
  * @author SpeedyPotato
  *
- * To add a lighting mode, create a function which accepts a uint32_t counter and bool hid_mode as parameters.
- * Create lighting mode as desired and then add the #include here.
+ * To add a lighting mode, create a function which accepts a void *ctx (its state) and a
+ * const rgb_frame_t *frame as parameters.
+ * Create lighting mode as desired, add the #include here and append it to rgb_effects[]
+ * in effect_registry.c.
+ *
+ * Effects must animate from frame->time_ms / frame->dt_ms rather than counting
+ * calls, so the render rate (WS2812B_FPS) can change without retuning them.
+ * Inputs come from frame->input (one consistent snapshot per frame), never
+ * from enc_val[] directly.
  **/
 
 // Forward declaration for RGB_t type (defined in main file)
 #ifndef RGB_T_DEFINED
 #define RGB_T_DEFINED
-typedef struct
+typedef union
 {
-  uint8_t r, g, b;
+  struct
+  {
+    uint8_t r, g, b, pad;
+  };
+  uint32_t u; // Packed word for the kernels in rgb/pixel_ops.c
 } RGB_t;
 #endif
 
-extern uint32_t enc_val[ENC_GPIO_SIZE];
+extern uint32_t enc_val[ENC_GPIO_SIZE];   // DMA-updated; read only by the input publisher
 extern RGB_t leds[WS2812B_LED_SIZE];      // Reference to FastLED-style LED array
-extern const bool ENC_REV[ENC_GPIO_SIZE]; // External reference to encoder reverse array
-extern volatile uint16_t g_buttons;       // Button bitmask published by core 0
 extern RGB_t hid_rgb[WS2812B_LED_ZONES];  // Two HID-provided RGB colors
 
+#include "input_snapshot.c"
+
+// Per-frame timing and input handed to every effect
+typedef struct
+{
+  uint32_t time_ms; // Elapsed time on the effect's own time base
+  uint32_t dt_ms;   // Time since the previous frame (0 when frozen)
+  bool hid_mode;     // No lights report or fade for REACTIVE_TIMEOUT_MAX (host not driving the lights)
+  bool overlay;      // Rendering as a compositor overlay: skip palette backgrounds
+  rgb_input_t input; // Buttons/encoders, identical for every layer this frame
+  const struct rgb_params *params; // This layer's tuned parameters (effect_params.c)
+} rgb_frame_t;
+
+// Effect state lives in context structs carved from a shared arena (see
+// effect_registry.c), never in function-level statics. Each slot holds one
+// effect context of up to this many bytes, including a full particle pool.
+#define RGB_EFFECT_CTX_MAX (96 + 4 * WS2812B_LED_SIZE + RGB_PARTICLE_POOL_BYTES)
+
+#include "pixel_ops.c"
 #include "ws2812b_util.c"
+#include "effect_params.c"
+#include "hid_keyframes.c"
+#include "led_layout.c"
+#include "particles.c"
 #include "color_cycle.c"
 #include "turbocharger.c"
 #include "trail.c"
 // New effects
-#include "demo_all.c"
 #include "dual_orbit.c"
 #include "velocity_comet.c"
 #include "button_ripples.c"
@@ -37,3 +68,14 @@ extern RGB_t hid_rgb[WS2812B_LED_ZONES];  // Two HID-provided RGB colors
 #include "center_pulse.c"
 #include "sector_equalizer.c"
 #include "radar_sweep.c"
+#include "hid_zones.c"
+#include "vm_core.c"
+#include "bytecode.c"
+#include "delta_codec.c"
+#include "clip.c"
+#include "host_stream.c"
+#include "custom_palette.c"
+// Registry of selectable effects (add new effects here too)
+#include "effect_registry.c"
+#include "transition.c"
+#include "compositor.c"
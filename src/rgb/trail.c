@@ -5,113 +5,87 @@
 
 #define NUM_TRAIL_POINTS 5
 
-static uint32_t trail_prev_enc_val = 0;
-static float trail_positions[NUM_TRAIL_POINTS] = {0};
-static uint8_t trail_brightness[WS2812B_LED_SIZE] = {0};
-static bool trail_initialized = false;
-static uint64_t last_encoder_change_time = 0;
+typedef struct
+{
+    rgb_particle_t points[NUM_TRAIL_POINTS];
+    rgb_levels_t brightness;
+    uint64_t last_encoder_change_time;
+    uint32_t decay_acc;
+} trail_ctx_t;
+_Static_assert(sizeof(trail_ctx_t) <= RGB_EFFECT_CTX_MAX, "trail_ctx_t exceeds arena slot");
 
-void ws2812b_trail(uint32_t counter, bool hid_mode)
+/**
+ * Init hook: spread the trail points evenly and restart the idle timer
+ **/
+void ws2812b_trail_init(void *ctx)
 {
-    int TRAIL_DECAY_RATE = 2;
-    // Initialize trail positions if not done yet
-    if (!trail_initialized)
+    trail_ctx_t *c = ctx;
+    for (int i = 0; i < NUM_TRAIL_POINTS; i++)
     {
-        for (int i = 0; i < NUM_TRAIL_POINTS; i++)
-        {
-            trail_positions[i] = (float)(i * WS2812B_LED_SIZE) / NUM_TRAIL_POINTS;
-        }
-        last_encoder_change_time = time_us_64(); // Initialize timestamp
-        trail_initialized = true;
+        c->points[i] = (rgb_particle_t){
+            .pos = rgb_led_turn(i * WS2812B_LED_SIZE / NUM_TRAIL_POINTS),
+            .life_ms = RGB_PARTICLE_IMMORTAL,
+            .level = 255,
+            .flags = RGB_KERNEL_GLOW, // Full at the point, >= 70% on its neighbors
+        };
     }
+    c->last_encoder_change_time = time_us_64(); // Initialize timestamp
+}
 
-    float position_delta = 0.0f;
+void ws2812b_trail(void *ctx, const rgb_frame_t *frame)
+{
+    trail_ctx_t *c = ctx;
+    int TRAIL_DECAY_RATE = frame->params->decay;
 
-    int enc_delta = (enc_val[0] - trail_prev_enc_val) * (ENC_REV[0] ? -1 : 1); // reverse the encoder value cuz i messed up the wiring lol
+    int enc_delta = frame->input.enc_delta[0]; // Profile direction already applied
 
     // Check if encoder value has changed
     if (enc_delta != 0)
     {
-        last_encoder_change_time = time_us_64();
+        c->last_encoder_change_time = frame->input.time_us;
     }
 
-    trail_prev_enc_val = enc_val[0];
-
     // Update trail positions based on encoder movement or timeout
-    uint64_t current_time = time_us_64();
-    uint64_t time_since_last_change = current_time - last_encoder_change_time;
+    uint64_t current_time = frame->input.time_us;
+    uint64_t time_since_last_change = current_time - c->last_encoder_change_time;
     const uint64_t TIMEOUT_3_SECONDS = 3000000; // 3 seconds in microseconds
 
+    int32_t vel = 0;
+    uint32_t jump = 0;
     if (time_since_last_change >= TIMEOUT_3_SECONDS)
     {
-        // No encoder movement for 3+ seconds, use slow automatic movement
-        position_delta = 0.05f;
-        TRAIL_DECAY_RATE = 4;
+        // No encoder movement for 3+ seconds, use slow automatic movement (0.05 LED per 5 ms tick)
+        vel = rgb_leds_to_turn(65536 / 100);
+        TRAIL_DECAY_RATE = TRAIL_DECAY_RATE > 4 ? TRAIL_DECAY_RATE / 4 : 1; // Longer tails while idle
     }
     else
     {
-        // Normal encoder-based movement
-        position_delta = (float)enc_delta / ENC_PULSE * WS2812B_LED_SIZE;
-        TRAIL_DECAY_RATE = 16;
-    } // Update all trail point positions
-    for (int i = 0; i < NUM_TRAIL_POINTS; i++)
-    {
-        trail_positions[i] += position_delta;
-
-        // Keep positions within bounds (circular)
-        while (trail_positions[i] < 0)
-            trail_positions[i] += WS2812B_LED_SIZE;
-        while (trail_positions[i] >= WS2812B_LED_SIZE)
-            trail_positions[i] -= WS2812B_LED_SIZE;
+        // Normal encoder-based movement: one full turn of the encoder is one lap
+        jump = (uint32_t)(((int64_t)enc_delta << 32) / frame->input.enc_pulse);
     }
-
-    // Decay all trail brightness values
-
-    for (int i = 0; i < WS2812B_LED_SIZE; i++)
+    for (int i = 0; i < NUM_TRAIL_POINTS; i++)
     {
-        if (trail_brightness[i] > 0)
-        {
-            trail_brightness[i] = trail_brightness[i] > TRAIL_DECAY_RATE ? trail_brightness[i] - TRAIL_DECAY_RATE : 0;
-        }
+        c->points[i].vel = vel;
+        c->points[i].pos += jump;
     }
+    rgb_particles_step(c->points, NUM_TRAIL_POINTS, frame->dt_ms);
 
-    // Set brightness at current positions for all 5 points
-    for (int point = 0; point < NUM_TRAIL_POINTS; point++)
-    {
-        int pos = (int)trail_positions[point];
-        if (pos >= 0 && pos < WS2812B_LED_SIZE)
-        {
-            // Each point has maximum brightness, trails will fade naturally
-            trail_brightness[pos] = 255;
-
-            // Add some brightness to adjacent LEDs for smoother effect
-            int prev_pos = (pos - 1 + WS2812B_LED_SIZE) % WS2812B_LED_SIZE;
-            int next_pos = (pos + 1) % WS2812B_LED_SIZE;
+    // Decay all trail brightness values (rate is per 5 ms tick)
+    rgb_levels_decay(&c->brightness, rgb_ticks_scaled(&c->decay_acc, TRAIL_DECAY_RATE, frame->dt_ms));
 
-            if (trail_brightness[prev_pos] < 180)
-                trail_brightness[prev_pos] = 180;
-            if (trail_brightness[next_pos] < 180)
-                trail_brightness[next_pos] = 180;
-        }
-    }
+    // Light the points; trails fade naturally with the decay above
+    rgb_particles_stamp(c->points, NUM_TRAIL_POINTS, &c->brightness);
 
     // Apply trail effect to LEDs
     for (int i = 0; i < WS2812B_LED_SIZE; i++)
     {
-        uint8_t brightness = trail_brightness[i];
-
-        // Change palette based on counter to demonstrate different palettes
-        // This cycles through palettes every ~10 seconds at 200Hz
-        // int demo_palette = (counter / 2000) % 9; // 9 palettes available (0-8)
-        set_color_palette(PALETTE_NEON);
+        uint8_t brightness = c->brightness.v[i];
 
         // Create a color that shifts through the spectrum based on position
         // Each of the 5 trail points will have different colors
-        uint32_t color = color_wheel((i * 768 / WS2812B_LED_SIZE + counter / 8) % 768);
+        uint32_t color = color_wheel((led_layout[i].wheel + frame->time_ms / 40) % 768);
 
         // Apply brightness scaling
-        leds[i].r = (((color >> 8) & 0xFF) * brightness) / 255;
-        leds[i].g = (((color >> 16) & 0xFF) * brightness) / 255;
-        leds[i].b = ((color & 0xFF) * brightness) / 255;
+        leds[i].u = rgb_px_scale(rgb_from_urgb(color), rgb_weight(brightness));
     }
 }
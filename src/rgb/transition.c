@@ -0,0 +1,45 @@
+/**
+ * Transition stage - crossfades from a snapshot of the outgoing frame
+ * @author Renard
+ *
+ * The outgoing frame is captured once when the transition begins; after
+ * that only the incoming effect renders, and its output is blended over the
+ * snapshot with an integer 0..256 weight.
+ **/
+
+typedef struct
+{
+  RGB_t from[WS2812B_LED_SIZE];
+  uint32_t elapsed_ms;
+  uint32_t duration_ms; // 0 = inactive
+} rgb_transition_t;
+
+/**
+ * Snapshot the current leds[] as the outgoing frame
+ * @param duration_ms Crossfade length; 0 switches immediately
+ **/
+static void rgb_transition_begin(rgb_transition_t *t, uint32_t duration_ms)
+{
+  memcpy(t->from, leds, sizeof(t->from));
+  t->elapsed_ms = 0;
+  t->duration_ms = duration_ms;
+}
+
+/**
+ * Blend the freshly rendered leds[] over the snapshot and advance
+ * @param dt_ms Frame delta in milliseconds
+ **/
+static void rgb_transition_apply(rgb_transition_t *t, uint32_t dt_ms)
+{
+  if (!t->duration_ms)
+    return;
+  t->elapsed_ms += dt_ms;
+  if (t->elapsed_ms >= t->duration_ms)
+  {
+    t->duration_ms = 0; // done, incoming frame shows as-is
+    return;
+  }
+  // Weight of the incoming frame, 0..256
+  uint32_t a = (t->elapsed_ms << 8) / t->duration_ms;
+  rgb_frame_lerp(leds, t->from, WS2812B_LED_SIZE, a);
+}
@@ -4,7 +4,7 @@
  *
  * Move 2 lighting areas around the controller depending on knob input.
  *
- * For each knob, calculate every 5 ms:
+ * For each knob, calculate every frame:
  * - Add any knob delta to a counter
  * - Clamp counter to some "maximum speed"
  * - If counter is far enough from 0, knob is moving
@@ -12,19 +12,19 @@
  * - Move the lighting area in the correct direction at a constant speed
  * - Decay the counter
  *
- * Curent values are tuned for
- * - Lights sampled at 200 Hz
+ * Curent values are expressed per 5 ms tick and scaled by the frame delta:
  * - 0.1 rotations for lights to activate
  * - Lighting areas take 0.75s to make one full rotation
  * - Movement takes 0.5s to decay to stop
  * - Fade out takes another 0.2s samples to disappear
  *
- * LEDs are positioned as:
- * - 0, 1 as dummy leds on top of controller
- * - 2-6 LEDs on right edge, top to bottom
- * - 7-9 as dummy leds on bottom of controller
- * - 10-14 LEDs on left edge, bottom to top
- * - 15 as dummy led on top of controller
+ * LEDs sit on the track slots given by led_layout[].track; the default ring
+ * layout places them as:
+ * - 0, 1 as dummy slots on top of controller
+ * - first half of the LEDs on the right edge, top to bottom
+ * - 3 dummy slots on bottom of controller
+ * - second half on the left edge, bottom to top
+ * - 1 dummy slot on top of controller
  *
  * Lighting areas start at position 0 and will light up the 3 nearest LEDs.
  * By strategically positioning led 0 at the top, this avoids lighting areas
@@ -35,8 +35,8 @@
 #define TURBO_LIGHTS_THRESHOLD 0.05f
 #define TURBO_LIGHTS_DECAY 0.0005f
 #define TURBO_LIGHTS_VEL 0.12f
-#define TURBO_LIGHTS_MAX (WS2812B_LED_SIZE + 6.0f)
-#define TURBO_LIGHTS_FADE 40
+#define TURBO_LIGHTS_MAX ((float)led_track_len)
+#define TURBO_LIGHTS_FADE_MS 200
 #define TURBO_LIGHTS_FADE_VEL 0.025f
 
 int i_clamp(int d, int min, int max)
@@ -62,62 +62,69 @@ float f_abs(float d)
   return d < 0 ? -d : d;
 }
 
-uint32_t turbo_prev_enc_val[ENC_GPIO_SIZE];
-float turbo_cur_enc_val[ENC_GPIO_SIZE];
-float turbo_lights_pos[ENC_GPIO_SIZE];
-float turbo_lights_brightness[ENC_GPIO_SIZE];
-int turbo_lights_idle[ENC_GPIO_SIZE];
+#define TURBO_AREAS 2 // One lighting area per knob (left, right)
 
-void turbocharger_color_cycle(uint32_t unused, bool hid_mode)
+typedef struct
 {
-  for (int i = 0; i < ENC_GPIO_SIZE; i++)
+  float cur_enc_val[TURBO_AREAS];
+  float lights_pos[TURBO_AREAS];
+  float lights_brightness[TURBO_AREAS];
+  uint32_t lights_idle_ms[TURBO_AREAS];
+} turbo_ctx_t;
+
+void turbocharger_color_cycle(void *ctx, const rgb_frame_t *frame)
+{
+  turbo_ctx_t *t = ctx;
+  const float ticks = rgb_ticks(frame->dt_ms);
+  // Areas without a knob stay dark (their brightness is never raised)
+  for (int i = 0; i < ENC_GPIO_SIZE && i < TURBO_AREAS; i++)
   {
-    int enc_delta = (enc_val[i] - turbo_prev_enc_val[i]) * (ENC_REV[i] ? 1 : -1);
-    turbo_prev_enc_val[i] = enc_val[i];
-    turbo_cur_enc_val[i] = f_clamp(turbo_cur_enc_val[i] + (float)(enc_delta) / ENC_PULSE, -TURBO_LIGHTS_CLAMP, TURBO_LIGHTS_CLAMP);
+    int enc_delta = -frame->input.enc_delta[i]; // Lights run against the knob
+    t->cur_enc_val[i] = f_clamp(t->cur_enc_val[i] + (float)(enc_delta) / frame->input.enc_pulse, -TURBO_LIGHTS_CLAMP, TURBO_LIGHTS_CLAMP);
 
-    if (turbo_cur_enc_val[i] < -TURBO_LIGHTS_THRESHOLD)
+    if (t->cur_enc_val[i] < -TURBO_LIGHTS_THRESHOLD)
     {
-      turbo_lights_idle[i] = 0;
-      turbo_lights_pos[i] += TURBO_LIGHTS_VEL;
-      turbo_lights_brightness[i] = 1.0f;
+      t->lights_idle_ms[i] = 0;
+      t->lights_pos[i] += TURBO_LIGHTS_VEL * ticks;
+      t->lights_brightness[i] = 1.0f;
     }
-    else if (turbo_cur_enc_val[i] > TURBO_LIGHTS_THRESHOLD)
+    else if (t->cur_enc_val[i] > TURBO_LIGHTS_THRESHOLD)
     {
-      turbo_lights_idle[i] = 0;
-      turbo_lights_pos[i] -= TURBO_LIGHTS_VEL;
-      turbo_lights_brightness[i] = 1.0f;
+      t->lights_idle_ms[i] = 0;
+      t->lights_pos[i] -= TURBO_LIGHTS_VEL * ticks;
+      t->lights_brightness[i] = 1.0f;
     }
     else
     {
-      turbo_lights_idle[i]++;
-      if (turbo_lights_idle[i] > TURBO_LIGHTS_FADE)
+      t->lights_idle_ms[i] += frame->dt_ms;
+      if (t->lights_idle_ms[i] > TURBO_LIGHTS_FADE_MS)
       {
-        turbo_lights_pos[i] = 0;
+        t->lights_pos[i] = 0;
       }
       else
       {
-        turbo_lights_brightness[i] = f_clamp(turbo_lights_brightness[i] - TURBO_LIGHTS_FADE_VEL, 0.0f, 1.0f);
+        t->lights_brightness[i] = f_clamp(t->lights_brightness[i] - TURBO_LIGHTS_FADE_VEL * ticks, 0.0f, 1.0f);
       }
     }
 
-    turbo_lights_pos[i] = f_one_mod(turbo_lights_pos[i], TURBO_LIGHTS_MAX);
+    t->lights_pos[i] = f_one_mod(t->lights_pos[i], TURBO_LIGHTS_MAX);
 
-    if (turbo_cur_enc_val[i] < -TURBO_LIGHTS_DECAY)
+    const float decay = TURBO_LIGHTS_DECAY * ticks;
+    if (t->cur_enc_val[i] < -decay)
     {
-      turbo_cur_enc_val[i] += TURBO_LIGHTS_DECAY;
+      t->cur_enc_val[i] += decay;
     }
-    else if (turbo_cur_enc_val[i] > TURBO_LIGHTS_DECAY)
+    else if (t->cur_enc_val[i] > decay)
     {
-      turbo_cur_enc_val[i] -= TURBO_LIGHTS_DECAY;
+      t->cur_enc_val[i] -= decay;
     }
   }
 
   for (int i = 0; i < WS2812B_LED_SIZE; i++)
   {
-    float pos = 2.0f + i + (i >= WS2812B_LED_SIZE / 2 ? 3.0f : 0.0f);
-    float l_strength = (1.0f - f_clamp(f_abs(turbo_lights_pos[0] - pos), 0.0f, 2.0f) / 2) * turbo_lights_brightness[0];
-    float r_strength = (1.0f - f_clamp(f_abs(turbo_lights_pos[1] - pos), 0.0f, 2.0f) / 2) * turbo_lights_brightness[1];
+    float pos = led_layout[i].track;
+    float l_strength = (1.0f - f_clamp(f_abs(t->lights_pos[0] - pos), 0.0f, 2.0f) / 2) * t->lights_brightness[0];
+    float r_strength = (1.0f - f_clamp(f_abs(t->lights_pos[1] - pos), 0.0f, 2.0f) / 2) * t->lights_brightness[1];
 
     // Set colors in leds array instead of calling put_pixel directly
     leds[i].r = i_clamp(l_strength * 70 + r_strength * 250, 0, 255);
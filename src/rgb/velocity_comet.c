@@ -1,51 +1,61 @@
 /** Velocity comet with deceleration sparks **/
-#include <math.h>
-void ws_velocity_comet(uint32_t counter, bool hid_mode)
+#define COMET_SPARKS 8
+#define COMET_SPARK_MS 40      // Spark life
+#define COMET_SMOOTH_Q16 2086  // Velocity follows the encoder by 1 - 0.85^(1/5) per ms
+
+typedef struct
 {
-    static uint32_t prev_enc = 0;
-    int d = (int)(enc_val[0] - prev_enc);
-    prev_enc = enc_val[0];
-    static float vel = 0.0f;
-    float target = (float)d / ENC_PULSE * WS2812B_LED_SIZE;
-    vel = 0.85f * vel + 0.15f * target;
-    static float pos = 0.0f;
-    pos = fmodf(pos + vel, (float)WS2812B_LED_SIZE);
-    if (pos < 0)
-        pos += WS2812B_LED_SIZE;
+    rgb_particle_t head;
+    rgb_particle_t sparks[COMET_SPARKS];
+    int32_t last_vel;
+    uint32_t decay_acc;
+    rgb_levels_t trail;
+} velocity_comet_ctx_t;
+_Static_assert(sizeof(velocity_comet_ctx_t) <= RGB_EFFECT_CTX_MAX, "velocity_comet_ctx_t exceeds arena slot");
 
-    set_color_palette(PALETTE_PLASMA);
+void ws_velocity_comet(void *ctx, const rgb_frame_t *frame)
+{
+    velocity_comet_ctx_t *c = ctx;
+    rgb_particle_t *head = &c->head;
+    if (!head->life_ms)
+        *head = (rgb_particle_t){.life_ms = RGB_PARTICLE_IMMORTAL, .level = 255, .flags = RGB_KERNEL_GLOW};
 
-    static uint8_t trail[WS2812B_LED_SIZE] = {0};
-    // decay trail proportional to speed
-    int decay = (int)fminf(16.0f, fabsf(vel) * 6.0f + 2.0f);
-    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
-        trail[i] = trail[i] > decay ? trail[i] - decay : 0;
+    // Target velocity from this frame's encoder movement (one encoder turn = one lap),
+    // smoothed by 15% per 5 ms tick
+    int d = frame->input.enc_delta[0];
+    uint32_t dt = frame->dt_ms;
+    int32_t target = dt ? (int32_t)(((int64_t)d << 32) / frame->input.enc_pulse / (int64_t)dt) : 0;
+    for (uint32_t t = 0; t < dt && t < 64; ++t)
+        head->vel += (int32_t)(((int64_t)(target - head->vel) * COMET_SMOOTH_Q16) >> 16);
+    rgb_particles_step(head, 1, dt);
+    rgb_particles_step(c->sparks, COMET_SPARKS, dt);
 
-    int p = (int)pos;
-    trail[p] = 255;
-    if (trail[(p + 1) % WS2812B_LED_SIZE] < 200)
-        trail[(p + 1) % WS2812B_LED_SIZE] = 200;
-    if (trail[(p - 1 + WS2812B_LED_SIZE) % WS2812B_LED_SIZE] < 200)
-        trail[(p - 1 + WS2812B_LED_SIZE) % WS2812B_LED_SIZE] = 200;
+    // decay trail proportional to speed: |vel| * 6 + decay per tick (vel in LEDs per tick), capped at 16
+    int32_t speed = head->vel < 0 ? -head->vel : head->vel;
+    int cap = frame->params->decay > 16 ? frame->params->decay : 16;
+    int64_t per_tick = (((int64_t)speed * RGB_TICK_MS * WS2812B_LED_SIZE * 6) >> 32) + frame->params->decay;
+    rgb_levels_decay(&c->trail, rgb_ticks_scaled(&c->decay_acc, per_tick > cap ? cap : (int)per_tick, dt));
 
-    // decel sparks
-    static float last_vel = 0.0f;
-    if (vel < last_vel - 0.02f)
+    // decel sparks, two LEDs behind the head, drifting back as they fade
+    if (c->last_vel - head->vel > (int32_t)(((int64_t)rgb_leds_to_turn(65536 / 50) * dt) / RGB_TICK_MS / RGB_TICK_MS))
     {
-        int s = (p + (vel > 0 ? -2 : 2) + WS2812B_LED_SIZE) % WS2812B_LED_SIZE;
-        trail[s] = 255;
+        rgb_particle_t *s = rgb_particle_spawn(c->sparks, COMET_SPARKS);
+        *s = (rgb_particle_t){.pos = head->pos + (uint32_t)rgb_leds_to_turn(head->vel > 0 ? -2 * 65536 : 2 * 65536),
+                              .vel = -head->vel / 4,
+                              .life_ms = COMET_SPARK_MS,
+                              .level = 255,
+                              .flags = RGB_KERNEL_NARROW,
+                              .fade = COMET_SPARK_MS / 4};
     }
-    last_vel = vel;
+    c->last_vel = head->vel;
+
+    rgb_particles_stamp(head, 1, &c->trail);
+    rgb_particles_stamp(c->sparks, COMET_SPARKS, &c->trail);
 
+    uint8_t *trail = c->trail.v;
     for (int i = 0; i < WS2812B_LED_SIZE; ++i)
     {
-        uint8_t br = trail[i];
-        uint32_t c = color_wheel((i * 768 / WS2812B_LED_SIZE + counter / 4) % 768);
-        uint8_t r = ((c >> 8) & 0xFF) * br / 255;
-        uint8_t g = ((c >> 16) & 0xFF) * br / 255;
-        uint8_t b = (c & 0xFF) * br / 255;
-        leds[i].r = r;
-        leds[i].g = g;
-        leds[i].b = b;
+        uint32_t pc = color_wheel((led_layout[i].wheel + frame->time_ms / 20) % 768);
+        leds[i].u = rgb_px_scale(rgb_from_urgb(pc), rgb_weight(trail[i]));
     }
 }
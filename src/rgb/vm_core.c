@@ -0,0 +1,310 @@
+/**
+ * Bytecode VM core - sandboxed fixed-point interpreter for uploaded effects
+ * @author Renard
+ *
+ * Portable C (no SDK headers), so tools/bench/rgb_vm_bench.c runs the very
+ * same interpreter on the host; bytecode.c wires it to flash, the input
+ * snapshot and leds[]. Needs RGB_t, pixel_ops.c and crc32.c.
+ *
+ * A program is an rgb_vm_header_t followed by `words` 32-bit instructions.
+ * The frame section, words [0, pixel_entry), runs once per frame; the
+ * pixel section, [pixel_entry, words), runs once per LED and sets its color
+ * with OUT. A section ends at HALT or by running off its end.
+ *
+ * Values are Q16.16 fixed point (1.0 = 0x10000, angles in turns); colors
+ * are packed RGB_t words. Encoding: op | d << 8 | a << 16 | b << 24, or
+ * op | d << 8 | imm16 << 16 for the immediate forms. Register and memory
+ * indices are masked, jumps may not leave their section and every
+ * instruction draws from a per-frame budget, so a program cannot reach
+ * outside its own state or stall the renderer.
+ **/
+
+#define RGB_VM_MAGIC 0x314D5652u // 'RVM1' LE
+#define RGB_VM_REGS 16
+#define RGB_VM_GLOBALS 16
+#define RGB_VM_ONE 0x10000
+
+typedef struct
+{
+  uint32_t magic;       // RGB_VM_MAGIC
+  uint16_t words;       // Instruction count
+  uint16_t pixel_entry; // First word of the pixel section
+  uint32_t crc32;       // Over the instructions
+  char name[16];        // NUL-padded
+} rgb_vm_header_t;
+
+// Opcodes; values are part of the upload format
+enum
+{
+  VM_HALT = 0x00,
+  VM_LDI = 0x01,    // d = sign-extended imm16 (raw)
+  VM_LDHI = 0x02,   // d = imm16 << 16 | (d & 0xFFFF)
+  VM_MOV = 0x03,    // d = a
+  VM_ADD = 0x04,    // d = a + b
+  VM_SUB = 0x05,    // d = a - b
+  VM_MUL = 0x06,    // d = a * b
+  VM_DIV = 0x07,    // d = a / b, 0 if b == 0
+  VM_MIN = 0x08,    // d = min(a, b)
+  VM_MAX = 0x09,    // d = max(a, b)
+  VM_ABS = 0x0A,    // d = |a|
+  VM_FRAC = 0x0B,   // d = a mod 1.0
+  VM_FLOOR = 0x0C,  // d = a rounded down to a whole number
+  VM_SLT = 0x0D,    // d = a < b ? 1.0 : 0
+  VM_SIN = 0x0E,    // d = sin(a turns)
+  VM_RAND = 0x0F,   // d = 0..1
+  VM_IN = 0x10,     // d = input[imm] (RGB_VM_IN_*)
+  VM_BTST = 0x11,   // d = bit int(b) of int(a) ? 1.0 : 0
+  VM_LDG = 0x12,    // d = global[imm]
+  VM_STG = 0x13,    // global[imm] = d
+  VM_LDP = 0x14,    // d = this LED's state word
+  VM_STP = 0x15,    // this LED's state word = d
+  VM_PAL = 0x20,    // d = active palette color at a turns
+  VM_HID = 0x21,    // d = HID color of zone int(a)
+  VM_RGB = 0x22,    // d = color(r = d, g = a, b = b), channels 0..1
+  VM_CSCALE = 0x23, // d = color a * clamp(b, 0, 1)
+  VM_CADD = 0x24,   // d = saturating color a + b
+  VM_CLERP = 0x25,  // d = color a -> b by clamp(d, 0, 1)
+  VM_OUT = 0x26,    // this LED's color = d (pixel section)
+  VM_JMP = 0x30,    // pc += imm
+  VM_JZ = 0x31,     // if d == 0: pc += imm
+  VM_JNZ = 0x32,    // if d != 0: pc += imm
+};
+
+// Inputs for VM_IN; whole numbers read as N.0
+enum
+{
+  RGB_VM_IN_TIME,    // Seconds since start (wraps after 32768 s)
+  RGB_VM_IN_DT,      // Frame delta, seconds
+  RGB_VM_IN_ENC0,    // Encoder 0 position, turns 0..1
+  RGB_VM_IN_ENC1,    // Encoder 1 position, turns 0..1
+  RGB_VM_IN_DENC0,   // Encoder 0 motion this frame, turns
+  RGB_VM_IN_DENC1,   // Encoder 1 motion this frame, turns
+  RGB_VM_IN_BUTTONS, // Held button mask
+  RGB_VM_IN_PRESSED, // Buttons pressed since the previous frame
+  RGB_VM_IN_HID,     // 1.0 once host lights have timed out (frame hid_mode), 0 while the host drives them
+  RGB_VM_IN_OVERLAY, // 1.0 when running as a compositor overlay
+  RGB_VM_IN_LEDS,    // LED count
+  RGB_VM_IN_LED,     // Pixel: index
+  RGB_VM_IN_RING,    // Pixel: position around the ring, turns 0..1
+  RGB_VM_IN_X,       // Pixel: layout x, -1..1
+  RGB_VM_IN_Y,       // Pixel: layout y, -1..1
+  RGB_VM_IN_ZONE,    // Pixel: HID zone
+  RGB_VM_IN_BUTTON,  // Pixel: button owning this LED's wedge
+  RGB_VM_IN_HELD,    // Pixel: 1.0 while that button is held
+  RGB_VM_IN_COUNT
+};
+
+// Everything a program may read, filled in by the host of the VM
+typedef struct
+{
+  int32_t in[RGB_VM_IN_COUNT];
+  const RGB_t *hid;                // HID zone colors
+  uint8_t hid_zones;
+  uint32_t (*palette)(int32_t pos); // Active palette at pos turns, packed
+} rgb_vm_io_t;
+
+// State kept across frames
+typedef struct
+{
+  int32_t global[RGB_VM_GLOBALS];
+  uint32_t rng;
+} rgb_vm_state_t;
+
+#define RGB_VM_OK 0
+#define RGB_VM_BUDGET 1 // Ran out of instructions this frame
+#define RGB_VM_FAULT 2  // Bad opcode or jump
+
+// Quarter sine wave, 64 steps, Q15
+static const int16_t rgb_vm_sin_q[65] = {
+    0, 804, 1608, 2410, 3212, 4011, 4808, 5602,
+    6393, 7179, 7962, 8739, 9512, 10278, 11039, 11793,
+    12539, 13279, 14010, 14732, 15446, 16151, 16846, 17530,
+    18204, 18868, 19519, 20159, 20787, 21403, 22005, 22594,
+    23170, 23731, 24279, 24811, 25329, 25832, 26319, 26790,
+    27245, 27683, 28105, 28510, 28898, 29268, 29621, 29956,
+    30273, 30571, 30852, 31113, 31356, 31580, 31785, 31971,
+    32137, 32285, 32412, 32521, 32609, 32678, 32728, 32757,
+    32767,
+};
+
+/**
+ * sin() of a Q16.16 angle in turns, Q16.16 result
+ **/
+static inline int32_t rgb_vm_sin(int32_t a)
+{
+  uint32_t p = (uint32_t)a & 0xFFFFu;
+  uint32_t x = p & 0x3FFFu;
+  if (p & 0x4000u)
+    x = 0x4000u - x; // Falling quarter mirrors the rising one
+  uint32_t i = x >> 8, f = x & 0xFFu;
+  int32_t s = i >= 64 ? rgb_vm_sin_q[64]
+                      : rgb_vm_sin_q[i] + (((rgb_vm_sin_q[i + 1] - rgb_vm_sin_q[i]) * (int32_t)f) >> 8);
+  s <<= 1; // Q15 -> Q16
+  return (p & 0x8000u) ? -s : s;
+}
+
+static inline uint32_t rgb_vm_unit(int32_t v)
+{
+  return v < 0 ? 0 : v > RGB_VM_ONE ? RGB_VM_ONE : (uint32_t)v;
+}
+
+/**
+ * CRC-32 (IEEE) used to validate uploads
+ **/
+static uint32_t rgb_vm_crc32(const uint8_t *p, uint32_t n)
+{
+  return ~crc32_update(0xFFFFFFFFu, p, n);
+}
+
+/**
+ * Check a program image before it is run or stored
+ * @param size Bytes available for header + code
+ **/
+static bool rgb_vm_validate(const rgb_vm_header_t *h, uint32_t size)
+{
+  if (size < sizeof(*h) || h->magic != RGB_VM_MAGIC)
+    return false;
+  if (h->words == 0 || (uint32_t)h->words * 4u > size - sizeof(*h) || h->pixel_entry > h->words)
+    return false;
+  return rgb_vm_crc32((const uint8_t *)(h + 1), (uint32_t)h->words * 4u) == h->crc32;
+}
+
+/**
+ * Run one section of a program
+ * @param code Instructions
+ * @param pc First word of the section
+ * @param end One past its last word
+ * @param px This LED's state word, NULL in the frame section
+ * @param out This LED's color, NULL in the frame section
+ * @param budget Instructions left this frame, decremented
+ * @return RGB_VM_OK, RGB_VM_BUDGET or RGB_VM_FAULT
+ **/
+static int rgb_vm_exec(const uint32_t *code, uint32_t pc, uint32_t end, rgb_vm_state_t *st,
+                       const rgb_vm_io_t *io, int32_t *px, uint32_t *out, uint32_t *budget)
+{
+  const uint32_t start = pc;
+  int32_t r[RGB_VM_REGS] = {0};
+  while (pc < end)
+  {
+    if (*budget == 0)
+      return RGB_VM_BUDGET;
+    --*budget;
+    uint32_t ins = code[pc++];
+    uint32_t op = ins & 0xFFu;
+    int32_t *d = &r[(ins >> 8) & (RGB_VM_REGS - 1)];
+    int32_t a = r[(ins >> 16) & (RGB_VM_REGS - 1)];
+    int32_t b = r[(ins >> 24) & (RGB_VM_REGS - 1)];
+    int32_t imm = (int16_t)(ins >> 16);
+    switch (op)
+    {
+    case VM_HALT:
+      return RGB_VM_OK;
+    case VM_LDI:
+      *d = imm;
+      break;
+    case VM_LDHI:
+      *d = (int32_t)((ins & 0xFFFF0000u) | ((uint32_t)*d & 0xFFFFu));
+      break;
+    case VM_MOV:
+      *d = a;
+      break;
+    case VM_ADD:
+      *d = (int32_t)((uint32_t)a + (uint32_t)b);
+      break;
+    case VM_SUB:
+      *d = (int32_t)((uint32_t)a - (uint32_t)b);
+      break;
+    case VM_MUL:
+      *d = (int32_t)(((int64_t)a * b) >> 16);
+      break;
+    case VM_DIV:
+    {
+      int64_t q = b ? ((int64_t)a * RGB_VM_ONE) / b : 0;
+      *d = q > INT32_MAX ? INT32_MAX : q < INT32_MIN ? INT32_MIN : (int32_t)q;
+      break;
+    }
+    case VM_MIN:
+      *d = a < b ? a : b;
+      break;
+    case VM_MAX:
+      *d = a > b ? a : b;
+      break;
+    case VM_ABS:
+      *d = a < 0 ? (int32_t)(0u - (uint32_t)a) : a;
+      break;
+    case VM_FRAC:
+      *d = a & 0xFFFF;
+      break;
+    case VM_FLOOR:
+      *d = (int32_t)((uint32_t)a & 0xFFFF0000u);
+      break;
+    case VM_SLT:
+      *d = a < b ? RGB_VM_ONE : 0;
+      break;
+    case VM_SIN:
+      *d = rgb_vm_sin(a);
+      break;
+    case VM_RAND:
+      st->rng ^= st->rng << 13, st->rng ^= st->rng >> 17, st->rng ^= st->rng << 5;
+      *d = (int32_t)(st->rng >> 16);
+      break;
+    case VM_IN:
+      *d = (uint32_t)imm < RGB_VM_IN_COUNT ? io->in[imm] : 0;
+      break;
+    case VM_BTST:
+      *d = ((uint32_t)(a >> 16) >> ((b >> 16) & 31)) & 1u ? RGB_VM_ONE : 0;
+      break;
+    case VM_LDG:
+      *d = st->global[imm & (RGB_VM_GLOBALS - 1)];
+      break;
+    case VM_STG:
+      st->global[imm & (RGB_VM_GLOBALS - 1)] = *d;
+      break;
+    case VM_LDP:
+      *d = px ? *px : 0;
+      break;
+    case VM_STP:
+      if (px)
+        *px = *d;
+      break;
+    case VM_PAL:
+      *d = (int32_t)io->palette(a);
+      break;
+    case VM_HID:
+      *d = (uint32_t)(a >> 16) < io->hid_zones ? (int32_t)(io->hid[a >> 16].u & 0x00FFFFFFu) : 0;
+      break;
+    case VM_RGB:
+      *d = (int32_t)rgb_pack((uint8_t)((rgb_vm_unit(*d) * 255u) >> 16),
+                             (uint8_t)((rgb_vm_unit(a) * 255u) >> 16),
+                             (uint8_t)((rgb_vm_unit(b) * 255u) >> 16));
+      break;
+    case VM_CSCALE:
+      *d = (int32_t)rgb_px_scale((uint32_t)a, rgb_vm_unit(b) >> 8);
+      break;
+    case VM_CADD:
+      *d = (int32_t)rgb_px_add_sat((uint32_t)a, (uint32_t)b);
+      break;
+    case VM_CLERP:
+      *d = (int32_t)rgb_px_lerp((uint32_t)a, (uint32_t)b, rgb_vm_unit(*d) >> 8);
+      break;
+    case VM_OUT:
+      if (out)
+        *out = (uint32_t)*d & 0x00FFFFFFu;
+      break;
+    case VM_JMP:
+    case VM_JZ:
+    case VM_JNZ:
+      if (op == VM_JMP || (op == VM_JZ) == (*d == 0))
+      {
+        int32_t to = (int32_t)pc + imm;
+        if (to < (int32_t)start || to > (int32_t)end)
+          return RGB_VM_FAULT;
+        pc = (uint32_t)to;
+      }
+      break;
+    default:
+      return RGB_VM_FAULT;
+    }
+  }
+  return RGB_VM_OK;
+}
@@ -2,8 +2,6 @@
  * ws2812b utility class with advanced palette system inspired by cpt-city
  * @author SpeedyPotato, Renard
  */
-#include "ws2812.pio.h"
-
 /**
  * WS2812B RGB Format Helper
  **/
@@ -22,10 +20,47 @@ static inline uint32_t urgb_u32(uint8_t r, uint8_t g, uint8_t b)
 #define PALETTE_ARCTIC 6
 #define PALETTE_EARTH 7
 #define PALETTE_NEON 8
-#define PALETTE_COUNT 9
+#define PALETTE_COUNT 9  // Built-in palettes
+#define PALETTE_CUSTOM 9 // First uploaded palette slot (custom_palette.c)
+#define RGB_CUSTOM_PALETTES 4
+#define RGB_PALETTE_TOTAL (PALETTE_COUNT + RGB_CUSTOM_PALETTES)
+
+// Palettes are baked into lookup tables at boot, so a wheel lookup is a
+// table read and an integer blend instead of float segment math per pixel
+#define RGB_PALETTE_LUT_SIZE 256 // Entries per palette, 3 wheel steps each
+static uint32_t rgb_palette_lut[RGB_PALETTE_TOTAL][RGB_PALETTE_LUT_SIZE + 1]; // + wrap entry
 
 // Current active palette (can be changed at runtime)
 static int current_palette = PALETTE_SUNSET;
+static const uint32_t *current_palette_lut = rgb_palette_lut[PALETTE_SUNSET];
+
+// Effects were originally tuned per 5 ms frame (200 Hz); per-tick constants
+// are kept as-is and rescaled by the real frame delta with these helpers.
+#define RGB_TICK_MS 5
+
+/**
+ * Number of legacy 5 ms ticks covered by a frame delta
+ * @param dt_ms Frame delta in milliseconds
+ **/
+static inline float rgb_ticks(uint32_t dt_ms)
+{
+  return (float)dt_ms / RGB_TICK_MS;
+}
+
+/**
+ * Integer per-tick amount scaled to a frame delta, carrying the remainder
+ * so slow decays still advance at high frame rates.
+ * @param acc Per-effect remainder accumulator
+ * @param per_tick Amount per legacy 5 ms tick
+ * @param dt_ms Frame delta in milliseconds
+ **/
+static inline int rgb_ticks_scaled(uint32_t *acc, int per_tick, uint32_t dt_ms)
+{
+  *acc += (uint32_t)per_tick * dt_ms;
+  int n = (int)(*acc / RGB_TICK_MS);
+  *acc %= RGB_TICK_MS;
+  return n;
+}
 
 /**
  * Linear interpolation between two RGB values
@@ -241,32 +276,61 @@ static inline uint32_t get_palette_color(int palette_type, float position)
 
 /**
  * Set the current color palette
- * @param palette The palette to use (0-8)
+ * @param palette The palette to use (0-8 built in, PALETTE_CUSTOM.. uploaded)
  */
 static inline void set_color_palette(int palette)
 {
-  if (palette >= 0 && palette < PALETTE_COUNT)
+  if (palette >= 0 && palette < RGB_PALETTE_TOTAL)
   {
     current_palette = palette;
+    current_palette_lut = rgb_palette_lut[palette];
   }
 }
 
+/**
+ * Bake every built-in palette into its lookup table (once, before the first
+ * frame); uploaded slots are baked by rgb_custom_palettes_sync()
+ **/
+static void rgb_palettes_init(void)
+{
+  for (int p = 0; p < PALETTE_COUNT; ++p)
+  {
+    for (int i = 0; i < RGB_PALETTE_LUT_SIZE; ++i)
+      rgb_palette_lut[p][i] = get_palette_color(p, (float)i / RGB_PALETTE_LUT_SIZE);
+    rgb_palette_lut[p][RGB_PALETTE_LUT_SIZE] = rgb_palette_lut[p][0];
+  }
+}
+
+/**
+ * Wheel lookup in a baked palette
+ * @param lut Palette table (rgb_palette_lut[...])
+ * @param wheel_pos Color value (0-767, cyclical)
+ **/
+static inline uint32_t palette_wheel(const uint32_t *lut, uint16_t wheel_pos)
+{
+  uint32_t pos = wheel_pos % 768u;
+  uint32_t i = pos / 3, f = pos % 3;
+  // Thirds between entries: weights 85 and 171 of 256
+  return f ? rgb_px_lerp(lut[i], lut[i + 1], f * 85 + (f >> 1)) : lut[i];
+}
+
 /**
  * 768 Color Wheel Picker with Palette System
  * @param wheel_pos Color value (0-767, cyclical)
  **/
 static inline uint32_t color_wheel(uint16_t wheel_pos)
 {
-  // Convert wheel position to 0.0-1.0 range for palette lookup
-  float position = (float)(wheel_pos % 768) / 768.0f;
-  return get_palette_color(current_palette, position);
+  return palette_wheel(current_palette_lut, wheel_pos);
 }
 
 /**
- * WS2812B RGB Assignment
- * @param pixel_grb The pixel color to set
+ * Palette background for effects that draw reactive highlights over a dim
+ * palette. Returns black when the effect runs as a compositor overlay, so
+ * the base layer shows through instead.
+ * @param frame Current frame
+ * @param wheel_pos Color value (0-767, cyclical)
  **/
-static inline void put_pixel(uint32_t pixel_grb)
+static inline uint32_t background_wheel(const rgb_frame_t *frame, uint16_t wheel_pos)
 {
-  pio_sm_put_blocking(pio1, ENC_GPIO_SIZE, pixel_grb << 8u);
+  return frame->overlay ? 0 : color_wheel(wheel_pos);
 }
\ No newline at end of file
@@ -0,0 +1,130 @@
+/**
+ * Settings journal - wear-leveled, append-only settings records
+ * @author Renard
+ *
+ * Each save appends the whole settings block as a new record to a ring of
+ * SETTINGS_JOURNAL_SECTORS flash sectors, one record per flash page. A
+ * record carries a sequence number and a CRC; at boot every page is
+ * scanned and the valid record with the highest sequence wins, so a record
+ * torn by a power cut is skipped and the one before it loads.
+ *
+ * A sector is erased only when the ring wraps into it, and then it holds
+ * nothing but records older than the ones in the sector just filled. A
+ * save costs one page program; the erases are spread evenly over the
+ * sectors, one per SETTINGS_JOURNAL_PAGES_PER_SECTOR saves.
+ *
+ * Host test against a simulated flash: tools/bench/settings_journal_bench.c
+ **/
+
+#define SETTINGS_JOURNAL_MAGIC 0x314A5253u // 'SRJ1' LE
+#define SETTINGS_JOURNAL_PAGES_PER_SECTOR (FLASH_SECTOR_SZ / FLASH_PAGE_SZ)
+#define SETTINGS_JOURNAL_PAGES (SETTINGS_JOURNAL_SECTORS * SETTINGS_JOURNAL_PAGES_PER_SECTOR)
+_Static_assert(SETTINGS_JOURNAL_SECTORS >= 2, "the journal needs a sector to fall back on while erasing");
+
+typedef struct
+{
+  uint32_t magic; // SETTINGS_JOURNAL_MAGIC
+  uint32_t seq;   // Increases by one per save
+  uint16_t len;   // Payload bytes following the header
+  uint16_t reserved;
+  uint32_t crc32; // Over seq..reserved and the payload
+} settings_record_t;
+
+#define SETTINGS_RECORD_MAX (FLASH_PAGE_SZ - sizeof(settings_record_t))
+
+static uint32_t settings_journal_seq = 0;     // Sequence of the latest record
+static int32_t settings_journal_latest = -1;  // Page of the latest record, -1 = none
+static uint32_t settings_journal_next = 0;    // Page the next record goes to
+
+static inline const settings_record_t *settings_journal_page(uint32_t page)
+{
+  return (const settings_record_t *)(XIP_BASE + SETTINGS_FLASH_OFFSET + page * FLASH_PAGE_SZ);
+}
+
+static uint32_t settings_record_crc(const settings_record_t *r)
+{
+  uint32_t crc = crc32_update(0xFFFFFFFFu, (const uint8_t *)&r->seq, offsetof(settings_record_t, crc32) - offsetof(settings_record_t, seq));
+  return ~crc32_update(crc, (const uint8_t *)(r + 1), r->len);
+}
+
+/**
+ * Find the latest valid record and where the next one goes (boot)
+ **/
+static void settings_journal_scan(void)
+{
+  settings_journal_latest = -1;
+  settings_journal_seq = 0;
+  for (uint32_t p = 0; p < SETTINGS_JOURNAL_PAGES; ++p)
+  {
+    const settings_record_t *r = settings_journal_page(p);
+    if (r->magic != SETTINGS_JOURNAL_MAGIC || r->len > SETTINGS_RECORD_MAX || settings_record_crc(r) != r->crc32)
+      continue;
+    if (settings_journal_latest < 0 || (int32_t)(r->seq - settings_journal_seq) > 0)
+    {
+      settings_journal_latest = (int32_t)p;
+      settings_journal_seq = r->seq;
+    }
+  }
+  settings_journal_next = settings_journal_latest < 0 ? 0 : (uint32_t)(settings_journal_latest + 1) % SETTINGS_JOURNAL_PAGES;
+}
+
+/**
+ * Payload of the latest record
+ * @param len Out: payload bytes
+ * @return NULL if the journal holds no valid record
+ **/
+static const uint8_t *settings_journal_read(uint16_t *len)
+{
+  if (settings_journal_latest < 0)
+    return NULL;
+  const settings_record_t *r = settings_journal_page((uint32_t)settings_journal_latest);
+  *len = r->len;
+  return (const uint8_t *)(r + 1);
+}
+
+static bool settings_journal_blank(uint32_t page)
+{
+  const uint32_t *w = (const uint32_t *)settings_journal_page(page);
+  for (uint32_t i = 0; i < FLASH_PAGE_SZ / 4; ++i)
+    if (w[i] != 0xFFFFFFFFu)
+      return false;
+  return true;
+}
+
+/**
+ * Append a record holding data
+ * @param len At most SETTINGS_RECORD_MAX
+ * @return false if no page took the record (flash worn out)
+ **/
+static bool settings_journal_append(const void *data, uint16_t len)
+{
+  uint8_t page[FLASH_PAGE_SZ];
+  settings_record_t *r = (settings_record_t *)page;
+  memset(page, 0xFF, sizeof(page));
+  r->magic = SETTINGS_JOURNAL_MAGIC;
+  r->seq = settings_journal_seq + 1;
+  r->len = len;
+  r->reserved = 0;
+  memcpy(r + 1, data, len);
+  r->crc32 = settings_record_crc(r);
+
+  for (uint32_t tries = 0; tries < SETTINGS_JOURNAL_PAGES; ++tries)
+  {
+    uint32_t p = settings_journal_next;
+    settings_journal_next = (p + 1) % SETTINGS_JOURNAL_PAGES;
+    uint32_t offset = SETTINGS_FLASH_OFFSET + p * FLASH_PAGE_SZ;
+    if (p % SETTINGS_JOURNAL_PAGES_PER_SECTOR == 0)
+      flash_write(offset, page, FLASH_PAGE_SZ); // Entering the oldest sector: reclaim it
+    else if (settings_journal_blank(p))
+      flash_program(offset, page, FLASH_PAGE_SZ);
+    else
+      continue; // Torn record or foreign data: leave it for the next erase
+    if (memcmp(settings_journal_page(p), page, FLASH_PAGE_SZ) == 0)
+    {
+      settings_journal_latest = (int32_t)p;
+      settings_journal_seq = r->seq;
+      return true;
+    }
+  }
+  return false;
+}
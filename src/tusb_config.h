@@ -103,7 +103,9 @@ extern "C" {
 #define CFG_TUD_VENDOR 0
 
 // HID buffer size Should be sufficient to hold ID (if any) + Data
-#define CFG_TUD_HID_EP_BUFSIZE 64
+// Also bounds feature reports over the control endpoint (TLV_REPORT_SIZE + ID);
+// the interrupt endpoint packet size is HID_EP_PACKET_SIZE
+#define CFG_TUD_HID_EP_BUFSIZE 256
 
 #ifdef __cplusplus
 }
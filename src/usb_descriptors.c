@@ -90,13 +90,17 @@ uint8_t const *tud_descriptor_device_cb(void)
 uint8_t const desc_hid_report_joy[] = {
     GAMECON_REPORT_DESC_JOYSTICK(HID_REPORT_ID(REPORT_ID_JOYSTICK)),
     GAMECON_REPORT_DESC_LIGHTS(HID_REPORT_ID(REPORT_ID_LIGHTS)),
-    GAMECON_REPORT_DESC_CONFIG(HID_REPORT_ID(REPORT_ID_CONFIG))};
+    GAMECON_REPORT_DESC_CONFIG(HID_REPORT_ID(REPORT_ID_CONFIG)),
+    GAMECON_REPORT_DESC_STREAM(HID_REPORT_ID(REPORT_ID_STREAM)),
+    GAMECON_REPORT_DESC_TLV(HID_REPORT_ID(REPORT_ID_TLV))};
 
 uint8_t const desc_hid_report_key[] = {
     GAMECON_REPORT_DESC_LIGHTS(HID_REPORT_ID(REPORT_ID_LIGHTS)),
     GAMECON_REPORT_DESC_NKRO(HID_REPORT_ID(REPORT_ID_KEYBOARD)),
     TUD_HID_REPORT_DESC_MOUSE(HID_REPORT_ID(REPORT_ID_MOUSE)),
-    GAMECON_REPORT_DESC_CONFIG(HID_REPORT_ID(REPORT_ID_CONFIG))};
+    GAMECON_REPORT_DESC_CONFIG(HID_REPORT_ID(REPORT_ID_CONFIG)),
+    GAMECON_REPORT_DESC_STREAM(HID_REPORT_ID(REPORT_ID_STREAM)),
+    GAMECON_REPORT_DESC_TLV(HID_REPORT_ID(REPORT_ID_TLV))};
 
 // Invoked when received GET HID REPORT DESCRIPTOR
 // Application return pointer to descriptor
@@ -131,7 +135,7 @@ uint8_t const desc_configuration_joy[] = {
     // address, size & polling interval
     TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_joy), EPNUM_HID,
-                       CFG_TUD_HID_EP_BUFSIZE, 1)};
+                       HID_EP_PACKET_SIZE, 1)};
 
 uint8_t const desc_configuration_key[] = {
     // Config number, interface count, string index, total length, attribute,
@@ -143,7 +147,7 @@ uint8_t const desc_configuration_key[] = {
     // address, size & polling interval
     TUD_HID_DESCRIPTOR(ITF_NUM_HID, 0, HID_ITF_PROTOCOL_NONE,
                        sizeof(desc_hid_report_key), EPNUM_HID,
-                       CFG_TUD_HID_EP_BUFSIZE, 1)};
+                       HID_EP_PACKET_SIZE, 1)};
 
 // Invoked when received GET CONFIGURATION DESCRIPTOR
 // Application return pointer to descriptor
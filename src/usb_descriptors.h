@@ -12,8 +12,17 @@ enum
       REPORT_ID_KEYBOARD,
       REPORT_ID_MOUSE,
       REPORT_ID_CONFIG,
+      REPORT_ID_STREAM,
+      REPORT_ID_TLV,
 };
 
+// Stream output report: [seq, flags, len, tokens...] (see rgb/host_stream.c)
+#define STREAM_REPORT_SIZE 63
+// TLV config feature report: [version, txn, items...] (see tlv_transaction());
+// control transfers only, so it may exceed the interrupt endpoint packet
+#define TLV_REPORT_SIZE 255
+#define HID_EP_PACKET_SIZE 64 // Interrupt IN endpoint max packet (full speed)
+
 // because they are missing from tusb_hid.h
 #define HID_STRING_INDEX(x) HID_REPORT_ITEM(x, 7, RI_TYPE_LOCAL, 1)
 #define HID_STRING_INDEX_N(x, n) HID_REPORT_ITEM(x, 7, RI_TYPE_LOCAL, n)
@@ -75,4 +84,24 @@ enum
           HID_FEATURE(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),             \
           HID_COLLECTION_END
 
+// Vendor-specific Feature report for batched TLV configuration transactions
+#define GAMECON_REPORT_DESC_TLV(...)                                       \
+      HID_USAGE_PAGE_N(0xFFAF, 2), /* vendor */                            \
+          HID_USAGE(0x03), HID_COLLECTION(HID_COLLECTION_APPLICATION),     \
+          __VA_ARGS__ HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0x00ff, 2), \
+          HID_REPORT_SIZE(8), HID_REPORT_COUNT(TLV_REPORT_SIZE),           \
+          HID_USAGE(0x03),                                                 \
+          HID_FEATURE(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),             \
+          HID_COLLECTION_END
+
+// Vendor-specific Output report for host-streamed LED frames
+#define GAMECON_REPORT_DESC_STREAM(...)                                    \
+      HID_USAGE_PAGE_N(0xFFAF, 2), /* vendor */                            \
+          HID_USAGE(0x02), HID_COLLECTION(HID_COLLECTION_APPLICATION),     \
+          __VA_ARGS__ HID_LOGICAL_MIN(0x00), HID_LOGICAL_MAX_N(0x00ff, 2), \
+          HID_REPORT_SIZE(8), HID_REPORT_COUNT(STREAM_REPORT_SIZE),        \
+          HID_USAGE(0x02),                                                 \
+          HID_OUTPUT(HID_DATA | HID_VARIABLE | HID_ABSOLUTE),              \
+          HID_COLLECTION_END
+
 #endif /* USB_DESCRIPTORS_H_ */
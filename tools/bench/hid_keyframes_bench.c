@@ -0,0 +1,102 @@
+/**
+ * Host test for HID keyframes (src/rgb/hid_keyframes.c)
+ *
+ * Runs the firmware's keyframe queue and interpolation against a simulated
+ * clock at 5 ms frames, the way ws2812b_update() does: a lights report,
+ * then a fade that outlasts REACTIVE_TIMEOUT_MAX. Checks that
+ *  - hid_mode stays off from the report through the end of the fade plus
+ *    the timeout, and turns on once, after that;
+ *  - the fade moves towards its target and ends on it;
+ *  - a lights report cancels a running fade.
+ * Exits non-zero on the first mismatch.
+ *
+ *   cc -O2 -o hid_keyframes_bench tools/bench/hid_keyframes_bench.c
+ *   ./hid_keyframes_bench
+ **/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define WS2812B_LED_SIZE 40
+#define WS2812B_LED_ZONES 2
+#define REACTIVE_TIMEOUT_MAX 1000000 // Same as controller_config.h
+#define FRAME_US 5000
+#define FADE_MS 3000 // Longer than the timeout
+
+typedef union
+{
+  struct
+  {
+    uint8_t r, g, b, pad;
+  };
+  uint32_t u;
+} RGB_t;
+
+static uint64_t sim_now_us = 0;
+static uint64_t time_us_64(void)
+{
+  return sim_now_us;
+}
+#define __dmb() ((void)0)
+
+#include "../../src/rgb/pixel_ops.c"
+#include "../../src/rgb/hid_keyframes.c"
+
+static void fail(const char *what, uint64_t t_us)
+{
+  printf("FAIL: %s (t = %llu ms)\n", what, (unsigned long long)(t_us / 1000));
+  exit(1);
+}
+
+int main(void)
+{
+  RGB_t report[WS2812B_LED_ZONES] = {{{0, 0, 0, 0}}, {{0, 0, 0, 0}}};
+  RGB_t target = {{255, 128, 0, 0}};
+  sim_now_us = 1000000;
+  uint64_t lights_us = sim_now_us; // Lights report: black
+  rgb_keyframe_push(RGB_KEYFRAME_ALL, target.u, RGB_EASE_LINEAR, FADE_MS, 0);
+  uint64_t fade_end = sim_now_us + FADE_MS * 1000ull;
+
+  uint32_t prev_r = 0;
+  int hid_mode_flips = 0;
+  bool prev_mode = false;
+  for (uint64_t t = sim_now_us; t < fade_end + 2 * REACTIVE_TIMEOUT_MAX; t += FRAME_US)
+  {
+    sim_now_us = t;
+    RGB_t rgb[WS2812B_LED_ZONES];
+    memcpy(rgb, report, sizeof(rgb));
+    uint64_t last = lights_us;
+    uint64_t kf = rgb_keyframes_apply(rgb, t);
+    if (kf > last)
+      last = kf;
+    bool hid_mode = rgb_hid_timed_out(t, last);
+    bool want = t >= fade_end + REACTIVE_TIMEOUT_MAX;
+    if (hid_mode != want)
+      fail(want ? "hid_mode still off after fade end + timeout" : "hid_mode on while the host drives the lights", t);
+    hid_mode_flips += hid_mode != prev_mode;
+    prev_mode = hid_mode;
+    if (rgb[0].r < prev_r)
+      fail("fade went backwards", t);
+    prev_r = rgb[0].r;
+    if (t >= fade_end && (rgb[0].u != target.u || rgb[1].u != target.u))
+      fail("fade did not end on its target", t);
+  }
+  printf("%d ms fade: hid_mode off until %d ms after it ended, %d flip(s)\n", FADE_MS,
+         REACTIVE_TIMEOUT_MAX / 1000, hid_mode_flips);
+
+  // A lights report mid-fade hands the zones back to it
+  sim_now_us += FRAME_US;
+  rgb_keyframe_push(0, 0, RGB_EASE_LINEAR, FADE_MS, 0);
+  RGB_t rgb[WS2812B_LED_ZONES];
+  memcpy(rgb, report, sizeof(rgb));
+  rgb_keyframes_apply(rgb, sim_now_us);
+  rgb_keyframe_cancel();
+  sim_now_us += FRAME_US;
+  memcpy(rgb, report, sizeof(rgb));
+  if (rgb_keyframes_apply(rgb, sim_now_us) != 0 || rgb[0].u != report[0].u)
+    fail("lights report did not cancel the fade", sim_now_us);
+  printf("OK\n");
+  return 0;
+}
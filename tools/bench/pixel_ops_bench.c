@@ -0,0 +1,158 @@
+/**
+ * Host microbenchmark for the packed-pixel kernels in src/rgb/pixel_ops.c
+ *
+ * Checks every kernel against a per-channel scalar reference, then times
+ * both over a frame buffer. Build with vectorization off so the numbers
+ * approximate a core without SIMD (like the RP2040's M0+):
+ *
+ *   cc -O2 -fno-tree-vectorize -o pixel_ops_bench tools/bench/pixel_ops_bench.c
+ *   ./pixel_ops_bench
+ **/
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define WS2812B_LED_SIZE 300
+
+typedef union
+{
+  struct
+  {
+    uint8_t r, g, b, pad;
+  };
+  uint32_t u;
+} RGB_t;
+
+#include "../../src/rgb/pixel_ops.c"
+
+#define ITERATIONS 20000
+
+static RGB_t frame_a[WS2812B_LED_SIZE], frame_b[WS2812B_LED_SIZE], out[WS2812B_LED_SIZE];
+static rgb_levels_t levels;
+static volatile uint32_t sink;
+
+static uint32_t rnd(void)
+{
+  static uint32_t x = 0x12345678u;
+  x ^= x << 13, x ^= x >> 17, x ^= x << 5;
+  return x;
+}
+
+static uint8_t ch(uint32_t p, int i) { return (p >> (8 * i)) & 0xFF; }
+
+static int verify(void)
+{
+  for (int n = 0; n < 1000000; ++n)
+  {
+    uint32_t a = rnd(), b = rnd(), t = rnd() % 257;
+    uint32_t sc = rgb_px_scale(a, t), lp = rgb_px_lerp(a, b, t);
+    uint32_t ad = rgb_px_add_sat(a, b), sb = rgb_px_sub_sat(a, b), mx = rgb_px_max(a, b);
+    for (int i = 0; i < 4; ++i)
+    {
+      int x = ch(a, i), y = ch(b, i);
+      if (ch(sc, i) != (x * t) >> 8 ||
+          ch(lp, i) != (x * (256 - t) + y * t) >> 8 ||
+          ch(ad, i) != (x + y > 255 ? 255 : x + y) ||
+          ch(sb, i) != (x > y ? x - y : 0) ||
+          ch(mx, i) != (x > y ? x : y))
+      {
+        printf("mismatch: a=%08x b=%08x t=%u lane %d\n", a, b, t, i);
+        return 1;
+      }
+    }
+  }
+  return 0;
+}
+
+static double elapsed_ns(clock_t start)
+{
+  return (double)(clock() - start) * 1e9 / CLOCKS_PER_SEC / ITERATIONS;
+}
+
+int main(void)
+{
+  if (verify())
+    return 1;
+  printf("kernels match scalar reference\n");
+  for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+    frame_a[i].u = rnd() & 0xFFFFFF, frame_b[i].u = rnd() & 0xFFFFFF, levels.v[i] = rnd();
+
+  clock_t t0;
+  printf("%-10s %12s %12s   (ns per %d-pixel frame)\n", "kernel", "scalar", "packed", WS2812B_LED_SIZE);
+
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+    {
+      uint8_t br = (uint8_t)n;
+      out[i].r = frame_a[i].r * br / 255;
+      out[i].g = frame_a[i].g * br / 255;
+      out[i].b = frame_a[i].b * br / 255;
+    }
+  double s_scale = elapsed_ns(t0);
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+      out[i].u = rgb_px_scale(frame_a[i].u, rgb_weight((uint8_t)n));
+  printf("%-10s %12.0f %12.0f\n", "scale", s_scale, elapsed_ns(t0));
+  sink = out[0].u;
+
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+  {
+    int a = n & 0xFF;
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+    {
+      out[i].r = frame_a[i].r + (((frame_b[i].r - frame_a[i].r) * a) >> 8);
+      out[i].g = frame_a[i].g + (((frame_b[i].g - frame_a[i].g) * a) >> 8);
+      out[i].b = frame_a[i].b + (((frame_b[i].b - frame_a[i].b) * a) >> 8);
+    }
+  }
+  double s_lerp = elapsed_ns(t0);
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+  {
+    memcpy(out, frame_b, sizeof(out));
+    rgb_frame_lerp(out, frame_a, WS2812B_LED_SIZE, n & 0xFF);
+  }
+  printf("%-10s %12.0f %12.0f\n", "lerp", s_lerp, elapsed_ns(t0));
+  sink = out[0].u;
+
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+    {
+      int r = frame_a[i].r + frame_b[i].r, g = frame_a[i].g + frame_b[i].g, b = frame_a[i].b + frame_b[i].b;
+      out[i].r = r > 255 ? 255 : r;
+      out[i].g = g > 255 ? 255 : g;
+      out[i].b = b > 255 ? 255 : b;
+    }
+  double s_add = elapsed_ns(t0);
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+      out[i].u = rgb_px_add_sat(frame_a[i].u, frame_b[i].u);
+  printf("%-10s %12.0f %12.0f\n", "add_sat", s_add, elapsed_ns(t0));
+  sink = out[0].u;
+
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+  {
+    int decay = (n & 3) + 1;
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+      levels.v[i] = levels.v[i] > decay ? levels.v[i] - decay : 0;
+    levels.v[n % WS2812B_LED_SIZE] = 255;
+  }
+  double s_decay = elapsed_ns(t0);
+  t0 = clock();
+  for (int n = 0; n < ITERATIONS; ++n)
+  {
+    rgb_levels_decay(&levels, (n & 3) + 1);
+    levels.v[n % WS2812B_LED_SIZE] = 255;
+  }
+  printf("%-10s %12.0f %12.0f\n", "decay", s_decay, elapsed_ns(t0));
+  sink = levels.w[0];
+  return 0;
+}
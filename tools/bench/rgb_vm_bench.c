@@ -0,0 +1,126 @@
+/**
+ * Host runner for bytecode effect programs (src/rgb/vm_core.c)
+ *
+ * Loads an image built by tools/rgbvm.py, runs it through the firmware's
+ * interpreter for a ring of LEDs with a button held and encoder 0 turning,
+ * and reports instructions and time per frame. -v prints the first frame.
+ *
+ *   cc -O2 -o rgb_vm_bench tools/bench/rgb_vm_bench.c
+ *   ./rgb_vm_bench prog.rvm [-v]
+ **/
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#define WS2812B_LED_SIZE 40
+#define WS2812B_LED_ZONES 2
+#define RGB_VM_INSNS_PER_FRAME 16000 // Same as controller_config.h
+#define IMAGE_MAX 4096
+#define FRAMES 20000
+
+typedef union
+{
+  struct
+  {
+    uint8_t r, g, b, pad;
+  };
+  uint32_t u;
+} RGB_t;
+
+#include "../../src/crc32.c"
+#include "../../src/rgb/pixel_ops.c"
+#include "../../src/rgb/vm_core.c"
+
+static uint32_t image[IMAGE_MAX / 4];
+static RGB_t hid[WS2812B_LED_ZONES] = {{{255, 0, 64, 0}}, {{0, 128, 255, 0}}};
+static int32_t px_state[WS2812B_LED_SIZE];
+static uint32_t out[WS2812B_LED_SIZE];
+
+// Stand-in for the palette: a plain hue wheel
+static uint32_t palette(int32_t pos)
+{
+  uint32_t h = ((uint32_t)pos & 0xFFFFu) * 3u; // 0..3 sectors in Q16
+  uint8_t f = (uint8_t)((h & 0xFFFFu) >> 8);
+  switch (h >> 16)
+  {
+  case 0:
+    return rgb_pack(255 - f, f, 0);
+  case 1:
+    return rgb_pack(0, 255 - f, f);
+  default:
+    return rgb_pack(f, 0, 255 - f);
+  }
+}
+
+/**
+ * One frame the way ws_bytecode() runs it
+ * @return Instructions executed
+ **/
+static uint32_t run_frame(const rgb_vm_header_t *h, rgb_vm_state_t *st, uint32_t frame, int *res)
+{
+  const uint32_t *code = (const uint32_t *)(h + 1);
+  rgb_vm_io_t io = {.hid = hid, .hid_zones = WS2812B_LED_ZONES, .palette = palette};
+  io.in[RGB_VM_IN_TIME] = (int32_t)(((uint64_t)frame * 5 << 16) / 1000);
+  io.in[RGB_VM_IN_DT] = (5 << 16) / 1000;
+  io.in[RGB_VM_IN_ENC0] = (int32_t)(frame * 64u & 0xFFFFu);
+  io.in[RGB_VM_IN_DENC0] = 64;
+  io.in[RGB_VM_IN_BUTTONS] = 1 << 16;
+  io.in[RGB_VM_IN_LEDS] = WS2812B_LED_SIZE << 16;
+  uint32_t budget = RGB_VM_INSNS_PER_FRAME;
+  *res = rgb_vm_exec(code, 0, h->pixel_entry, st, &io, NULL, NULL, &budget);
+  for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+  {
+    out[i] = 0;
+    if (*res != RGB_VM_OK)
+      continue;
+    io.in[RGB_VM_IN_LED] = i << 16;
+    io.in[RGB_VM_IN_RING] = (i << 16) / WS2812B_LED_SIZE;
+    io.in[RGB_VM_IN_ZONE] = (i * WS2812B_LED_ZONES / WS2812B_LED_SIZE) << 16;
+    io.in[RGB_VM_IN_BUTTON] = (i * 11 / WS2812B_LED_SIZE) << 16;
+    io.in[RGB_VM_IN_HELD] = i * 11 / WS2812B_LED_SIZE == 0 ? RGB_VM_ONE : 0;
+    *res = rgb_vm_exec(code, h->pixel_entry, h->words, st, &io, &px_state[i], &out[i], &budget);
+  }
+  return RGB_VM_INSNS_PER_FRAME - budget;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s prog.rvm [-v]\n", argv[0]);
+    return 2;
+  }
+  FILE *f = fopen(argv[1], "rb");
+  if (!f)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+  size_t n = fread(image, 1, sizeof(image), f);
+  fclose(f);
+  const rgb_vm_header_t *h = (const rgb_vm_header_t *)image;
+  if (!rgb_vm_validate(h, (uint32_t)n))
+  {
+    fprintf(stderr, "%s: not a valid program image\n", argv[1]);
+    return 1;
+  }
+  printf("%.16s: %u instructions (%u frame, %u pixel)\n", h->name, h->words, h->pixel_entry,
+         h->words - h->pixel_entry);
+
+  rgb_vm_state_t st = {.rng = 0x9E3779B9u};
+  int res;
+  uint32_t insns = run_frame(h, &st, 0, &res);
+  if (argc > 2 && !strcmp(argv[2], "-v"))
+    for (int i = 0; i < WS2812B_LED_SIZE; ++i)
+      printf("%2d: %02x %02x %02x\n", i, out[i] & 0xFF, (out[i] >> 8) & 0xFF, (out[i] >> 16) & 0xFF);
+
+  clock_t t0 = clock();
+  for (uint32_t fr = 1; fr <= FRAMES && res == RGB_VM_OK; ++fr)
+    insns = run_frame(h, &st, fr, &res);
+  double ns = (double)(clock() - t0) * 1e9 / CLOCKS_PER_SEC / FRAMES;
+  printf("%u instructions/frame (budget %u), %.0f ns/frame on this host, result %s\n", insns,
+         RGB_VM_INSNS_PER_FRAME, ns, res == RGB_VM_OK ? "ok" : res == RGB_VM_BUDGET ? "over budget" : "fault");
+  return res == RGB_VM_FAULT;
+}
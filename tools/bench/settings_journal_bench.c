@@ -0,0 +1,169 @@
+/**
+ * Host test for the settings journal (src/settings_journal.c)
+ *
+ * Runs the firmware's journal against a simulated NOR flash that only
+ * clears bits on program and insists on page/sector alignment, then:
+ *  - saves many times with periodic reboots (rescans), checking the latest
+ *    record each time, and counts erases per sector against the old
+ *    rewrite-one-sector-per-save scheme;
+ *  - cuts power at a random byte of a save's erase or program, reboots and
+ *    checks that either the new or the previous settings load.
+ * Exits non-zero on the first mismatch.
+ *
+ *   cc -O2 -o settings_journal_bench tools/bench/settings_journal_bench.c
+ *   ./settings_journal_bench
+ **/
+#include <setjmp.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FLASH_SECTOR_SZ 4096
+#define FLASH_PAGE_SZ 256
+#define SETTINGS_JOURNAL_SECTORS 4 // Same as pico_game_controller.c
+#define SETTINGS_FLASH_OFFSET 0
+#define SETTINGS_FLASH_SIZE (SETTINGS_JOURNAL_SECTORS * FLASH_SECTOR_SZ)
+#define RECORD_LEN 120 // sizeof(settings_t) at v6
+#define SAVES 100000
+#define CUTS 20000
+
+static uint8_t sim_flash[SETTINGS_FLASH_SIZE] __attribute__((aligned(4)));
+#define XIP_BASE ((uintptr_t)sim_flash)
+
+static uint32_t erases[SETTINGS_JOURNAL_SECTORS];
+static long cut_budget = -1; // Bytes of flash work until power is lost, -1 = never
+static jmp_buf power_lost;
+
+static void fail(const char *what, long i)
+{
+  printf("FAIL: %s (iteration %ld)\n", what, i);
+  exit(1);
+}
+
+static void sim_erase(uint32_t offset)
+{
+  if (offset % FLASH_SECTOR_SZ)
+    fail("unaligned erase", -1);
+  erases[offset / FLASH_SECTOR_SZ]++;
+  for (uint32_t i = 0; i < FLASH_SECTOR_SZ; ++i)
+  {
+    if (cut_budget >= 0 && cut_budget-- == 0)
+      longjmp(power_lost, 1); // Rest of the sector keeps its old bits
+    sim_flash[offset + i] = 0xFF;
+  }
+}
+
+static void sim_program(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  if (offset % FLASH_PAGE_SZ || len % FLASH_PAGE_SZ)
+    fail("unaligned program", -1);
+  for (uint32_t i = 0; i < len; ++i)
+  {
+    if (cut_budget >= 0 && cut_budget-- == 0)
+      longjmp(power_lost, 1);
+    sim_flash[offset + i] &= data[i]; // NOR: program only clears bits
+  }
+}
+
+static void flash_write(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  for (uint32_t s = 0; s < len; s += FLASH_SECTOR_SZ)
+    sim_erase(offset + s);
+  sim_program(offset, data, len);
+}
+
+static void flash_program(uint32_t offset, const uint8_t *data, uint32_t len)
+{
+  sim_program(offset, data, len);
+}
+
+#include "../../src/crc32.c"
+#include "../../src/settings_journal.c"
+
+// Deterministic settings contents for save number n
+static void make_record(uint8_t *rec, uint32_t n)
+{
+  uint32_t x = n * 2654435761u + 1;
+  for (int i = 0; i < RECORD_LEN; ++i)
+  {
+    x = x * 1664525u + 1013904223u;
+    rec[i] = (uint8_t)(x >> 24);
+  }
+}
+
+// What load_settings() would see after a reboot
+static bool latest_is(uint32_t n)
+{
+  uint8_t want[RECORD_LEN];
+  uint16_t len;
+  settings_journal_scan();
+  const uint8_t *got = settings_journal_read(&len);
+  make_record(want, n);
+  return got && len == RECORD_LEN && memcmp(got, want, RECORD_LEN) == 0;
+}
+
+int main(void)
+{
+  uint8_t rec[RECORD_LEN];
+  memset(sim_flash, 0xFF, sizeof(sim_flash));
+
+  // Empty flash: no record, first save lands at page 0
+  settings_journal_scan();
+  uint16_t len;
+  if (settings_journal_read(&len))
+    fail("record found in blank flash", 0);
+
+  // Wear: plain saves with a reboot now and then
+  for (long i = 1; i <= SAVES; ++i)
+  {
+    make_record(rec, (uint32_t)i);
+    if (!settings_journal_append(rec, RECORD_LEN))
+      fail("append", i);
+    if (i % 97 == 0 && !latest_is((uint32_t)i))
+      fail("latest after reboot", i);
+  }
+  uint32_t max_erases = 0;
+  for (int s = 0; s < SETTINGS_JOURNAL_SECTORS; ++s)
+    if (erases[s] > max_erases)
+      max_erases = erases[s];
+  printf("%d saves: %u erases on the busiest sector (one sector per save: %d), %.1fx less wear\n", SAVES, max_erases,
+         SAVES, (double)SAVES / max_erases);
+
+  // Power cuts: anywhere in a save's erase + program
+  srand(12345);
+  uint32_t committed = SAVES, next = SAVES + 1;
+  long survived_new = 0;
+  if (!latest_is(committed))
+    fail("latest before power cuts", 0);
+  for (long i = 0; i < CUTS; ++i)
+  {
+    make_record(rec, next);
+    cut_budget = rand() % (FLASH_SECTOR_SZ + FLASH_PAGE_SZ + 64);
+    if (setjmp(power_lost) == 0)
+    {
+      settings_journal_append(rec, RECORD_LEN);
+      cut_budget = -1;
+      committed = next++;
+      if (!latest_is(committed))
+        fail("latest after completed save", i);
+      continue;
+    }
+    cut_budget = -1; // Reboot
+    if (latest_is(next))
+    {
+      committed = next++; // Every byte made it before the cut
+      survived_new++;
+    }
+    else if (latest_is(committed))
+      next++; // Lost the save in flight, kept the one before
+    else
+      fail("neither the new nor the previous settings load after a power cut", i);
+  }
+  printf("%d power cuts: new or previous settings loaded every time (%ld saves fully written before the cut)\n", CUTS,
+         survived_new);
+  printf("OK\n");
+  return 0;
+}
@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+"""
+Packer and uploader for the firmware's "Clip" effect (src/rgb/clip.c).
+
+  python tools/clip_pack.py pack anim.png [-o anim.clp] [--fps 30] [--loop]
+  python tools/clip_pack.py pack --demo [-o demo.clp] [--fps 30] [--loop]
+  python tools/clip_pack.py upload anim.clp|anim.png [--fps 30] [--loop]
+  python tools/clip_pack.py status
+
+Source images are read with Pillow (pip install pillow). In a still image
+every row is one frame and every column one LED, in strip order; an
+animated GIF gives one frame per GIF frame, sampled along its top row.
+The width must be the LED count (--leds, default 40), or it is resampled.
+
+Frames are stored as deltas against the previous frame (skip / run /
+literal tokens, see src/rgb/delta_codec.c), so slow or mostly static
+animations pack far below their raw size. The image is decoded again after packing to
+check it round-trips.
+"""
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = 0x31504C43  # 'CLP1'
+LOOP = 0x0001
+HEADER = struct.Struct("<IHHHHII16s")
+IMAGE_MAX = 64 * 4096  # RGB_CLIP_FLASH_SIZE
+MAX_TOKEN = 64
+
+
+class ClipError(Exception):
+    pass
+
+
+def encode_tokens(prev, cur):
+    """Delta tokens (src/rgb/delta_codec.c) turning prev into cur, lists of (r, g, b)."""
+    out = []
+    i, n = 0, len(cur)
+    while i < n:
+        # Skip unchanged pixels
+        j = i
+        while j < n and j - i < MAX_TOKEN and cur[j] == prev[j]:
+            j += 1
+        if j > i:
+            out.append(bytes([0x00 | (j - i - 1)]))
+            i = j
+            continue
+        # Run of one color (worth it from 2 pixels on)
+        j = i
+        while j < n and j - i < MAX_TOKEN and cur[j] == cur[i]:
+            j += 1
+        if j - i >= 2:
+            out.append(bytes([0x40 | (j - i - 1)]) + bytes(cur[i]))
+            i = j
+            continue
+        # Literal until a skip or run would start
+        j = i
+        while j < n and j - i < MAX_TOKEN and cur[j] != prev[j] and \
+                not (j + 1 < n and cur[j + 1] == cur[j]):
+            j += 1
+        j = max(j, i + 1)
+        out.append(bytes([0x80 | (j - i - 1)]) + b"".join(bytes(px) for px in cur[i:j]))
+        i = j
+    return out
+
+
+def decode(image):
+    """Frames of a clip image, exactly as the firmware decodes them."""
+    magic, leds, frames, _, _, data_len, crc, _ = HEADER.unpack_from(image)
+    data = image[HEADER.size:HEADER.size + data_len]
+    if magic != MAGIC or len(data) != data_len or zlib.crc32(data) & 0xFFFFFFFF != crc:
+        raise ClipError("bad clip image")
+    cur = [(0, 0, 0)] * leds
+    pos, out = 0, []
+    for _ in range(frames):
+        cur = list(cur)
+        px = 0
+        while px < leds:
+            tag = data[pos]
+            pos += 1
+            kind, n = tag >> 6, (tag & 0x3F) + 1
+            if kind == 1:
+                cur[px:px + n] = [tuple(data[pos:pos + 3])] * n
+                pos += 3
+            elif kind == 2:
+                cur[px:px + n] = [tuple(data[pos + 3 * k:pos + 3 * k + 3]) for k in range(n)]
+                pos += 3 * n
+            elif kind != 0:
+                raise ClipError("bad token")
+            px += n
+        out.append(cur)
+    return out
+
+
+def pack(frames, fps, loop, name=b""):
+    """Return the clip image for a list of frames of (r, g, b) tuples."""
+    if not frames or len(frames) > 0xFFFF:
+        raise ClipError("need 1..65535 frames")
+    leds = len(frames[0])
+    data = bytearray()
+    prev = [(0, 0, 0)] * leds
+    for f in frames:
+        data += b"".join(encode_tokens(prev, f))
+        prev = f
+    frame_ms = max(1, round(1000 / fps))
+    image = HEADER.pack(MAGIC, leds, len(frames), frame_ms, LOOP if loop else 0, len(data),
+                        zlib.crc32(data) & 0xFFFFFFFF, name[:15]) + bytes(data)
+    if len(image) > IMAGE_MAX:
+        raise ClipError(f"clip is {len(image)} bytes, limit {IMAGE_MAX}")
+    if decode(image) != [list(f) for f in frames]:
+        raise ClipError("round-trip check failed")
+    return image
+
+
+def load_frames(path, leds):
+    try:
+        from PIL import Image, ImageSequence
+    except ImportError:
+        raise ClipError("reading images needs Pillow (pip install pillow)") from None
+    img = Image.open(path)
+    if getattr(img, "n_frames", 1) > 1:
+        rows = [f.convert("RGB").resize((leds, 1)) for f in ImageSequence.Iterator(img)]
+    else:
+        src = img.convert("RGB").resize((leds, img.height))
+        rows = [src.crop((0, y, leds, y + 1)) for y in range(src.height)]
+    return [list(r.getdata()) for r in rows]
+
+
+def demo_frames(leds, count=120):
+    """A hue comet over a dim, slowly breathing base."""
+    import colorsys
+    frames = []
+    for t in range(count):
+        head = t * leds // count
+        base = int(8 + 8 * (1 - abs(t - count / 2) / (count / 2)))
+        f = []
+        for i in range(leds):
+            d = (head - i) % leds
+            if d < 6:
+                r, g, b = colorsys.hsv_to_rgb(t / count, 1.0, 1.0 - d / 6)
+                f.append((int(r * 255), int(g * 255), int(b * 255)))
+            else:
+                f.append((0, 0, base))
+        frames.append(f)
+    return frames
+
+
+# ---- Device side (config feature report, see README) ----
+
+CMD_CLIP_BEGIN = 0x48
+CMD_CLIP_DATA = 0x49
+CMD_CLIP_COMMIT = 0x4A
+CMD_GET_CLIP_STATUS = 0x4B
+UPLOAD_STATES = ["idle", "receiving", "stored", "rejected", "writing"]
+
+
+def upload(dev, image, report_id):
+    dev.send_feature_report(bytes([report_id, CMD_CLIP_BEGIN] + [0] * 7))
+    for off in range(0, len(image), 4):
+        chunk = list(image[off:off + 4])
+        dev.send_feature_report(bytes([report_id, CMD_CLIP_DATA, off & 0xFF, off >> 8 & 0xFF, off >> 16]
+                                      + chunk + [0] * (4 - len(chunk))))
+    dev.send_feature_report(bytes([report_id, CMD_CLIP_COMMIT] + [0] * 7))
+
+
+def status(dev, report_id):
+    dev.send_feature_report(bytes([report_id, CMD_GET_CLIP_STATUS] + [0] * 7))
+    data = dev.get_feature_report(report_id, 9)
+    if not data or len(data) < 9:
+        return None
+    # [id, upload_state, valid, frames(lo,hi), frame_ms(lo,hi), size_kb(lo,hi)]
+    return {
+        "upload": UPLOAD_STATES[data[1]] if data[1] < len(UPLOAD_STATES) else data[1],
+        "valid": bool(data[2]),
+        "frames": data[3] | data[4] << 8,
+        "frame_ms": data[5] | data[6] << 8,
+        "size_kb": data[7] | data[8] << 8,
+    }
+
+
+def _opt(argv, flag, default):
+    return argv[argv.index(flag) + 1] if flag in argv else default
+
+
+def build(argv):
+    leds = int(_opt(argv, "--leds", 40))
+    fps = float(_opt(argv, "--fps", 30))
+    loop = "--loop" in argv
+    if "--demo" in argv:
+        return pack(demo_frames(leds), fps, loop, b"Demo"), "demo"
+    src = argv[2]
+    if src.endswith(".clp"):
+        with open(src, "rb") as f:
+            image = f.read()
+        decode(image)
+        return image, src.rsplit(".", 1)[0]
+    stem = src.rsplit(".", 1)[0]
+    return pack(load_frames(src, leds), fps, loop, stem.rsplit("/", 1)[-1].encode()), stem
+
+
+def main(argv):
+    if len(argv) < 2 or argv[1] not in ("pack", "upload", "status"):
+        print(__doc__)
+        return 2
+    try:
+        if argv[1] == "pack":
+            image, stem = build(argv)
+            out = _opt(argv, "-o", stem + ".clp")
+            with open(out, "wb") as f:
+                f.write(image)
+            _, leds, frames, _, _, data_len, _, _ = HEADER.unpack_from(image)
+            print(f"{out}: {frames} frames, {len(image)} bytes "
+                  f"({100 * data_len / (frames * leds * 3):.0f}% of raw)")
+            return 0
+        image = build(argv)[0] if argv[1] == "upload" else None
+    except (ClipError, OSError, IndexError, ValueError) as e:
+        print(f"ERR: {e}")
+        return 1
+
+    from effect_selector import REPORT_ID_CONFIG, HIDErrors, open_device
+    try:
+        dev = open_device()
+        if image is not None:
+            upload(dev, image, REPORT_ID_CONFIG)
+        st = status(dev, REPORT_ID_CONFIG)
+        deadline = time.monotonic() + 2
+        while st and st["upload"] == "writing" and time.monotonic() < deadline:
+            time.sleep(0.02)  # The device writes flash from its main loop
+            st = status(dev, REPORT_ID_CONFIG)
+        print(st if st else "ERR: no status")
+        return 0 if st and st["upload"] != "rejected" else 1
+    except (OSError, HIDErrors) as e:
+        print(f"ERR: {e}")
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -8,7 +8,9 @@ Debugging:
 - Use the "Debug HID" button to list all HID interfaces for this VID/PID.
 """
 
+import json
 import sys
+import time
 import tkinter as tk
 from tkinter import ttk, messagebox
 
@@ -41,6 +43,22 @@ PID = 0x8048
 
 # Report IDs must match firmware
 REPORT_ID_CONFIG = 5
+REPORT_ID_TLV = 7
+
+# Batched TLV transactions (firmware tlv_transaction()): [version, txn, items...]
+TLV_VERSION = 1
+TLV_REPORT_SIZE = 255
+TLV_OP_END = 0
+TLV_OP_GET = 1
+TLV_OP_SET = 2
+TLV_KEYS = {
+    "effect": 0x01, "brightness": 0x02, "transition": 0x03, "current_limit": 0x04,
+    "enc_ppr": 0x05, "mouse_sens": 0x06, "enc_debounce": 0x07, "layer": 0x08,
+    "effect_param": 0x09, "profile": 0x0A, "keymap": 0x0B, "enc_rev": 0x0C,
+    "sw_debounce": 0x0D, "device": 0x40, "settings": 0x7F,
+}
+TLV_KEY_NAMES = {v: k for k, v in TLV_KEYS.items()}
+TLV_STATUS = ["ok", "bad key", "bad value", "reply full"]
 
 # Commands
 CMD_SET_EFFECT = 0x01
@@ -50,23 +68,54 @@ CMD_SET_ENCODER_PPR = 0x10
 CMD_SET_MOUSE_SENS = 0x11
 CMD_SET_ENC_DEBOUNCE = 0x12
 CMD_SET_WS_PARAMS = 0x13
+CMD_SET_TRANSITION = 0x14
+CMD_SET_LAYER = 0x15
+CMD_SET_CURRENT_LIMIT = 0x16
+CMD_SET_EFFECT_PARAM = 0x17
+CMD_SET_PROFILE = 0x18
+CMD_SET_PROFILE_KEY = 0x19
+CMD_SET_ENC_REV = 0x1A
+CMD_SET_SW_DEBOUNCE = 0x1B
 CMD_GET_EXT_STATUS = 0x20
 
-EFFECTS = [
-    (0, "Color Cycle"),
-    (1, "Turbocharger"),
-    (2, "Trail"),
-    (3, "Dual Orbit"),
-    (4, "Velocity Comet"),
-    (5, "Button Ripples"),
-    (6, "Spokes"),
-    (7, "Counter Stripes"),
-    (8, "Palette Tint Gradient"),
-    (9, "Multipoint Snap"),
-    (10, "Center Pulse"),
-    (11, "Sector Equalizer"),
-    (12, "Radar Sweep"),
-]
+CMD_GET_EFFECT_INFO = 0x21
+CMD_GET_LAYER = 0x22
+CMD_GET_LATENCY = 0x23
+CMD_GET_EFFECT_PARAM = 0x24
+CMD_GET_FLASH_STATUS = 0x25
+CMD_GET_PROFILE = 0x26
+CMD_HID_KEYFRAME = 0x30
+CMD_PALETTE_BEGIN = 0x4C
+CMD_PALETTE_STOP = 0x4D
+CMD_PALETTE_COMMIT = 0x4E
+CMD_GET_PALETTE_STATUS = 0x4F
+
+# Keyframe zones and easing curves (firmware src/rgb/hid_keyframes.c)
+KEYFRAME_ALL_ZONES = 0x0F
+EASINGS = ["linear", "in", "out", "in-out", "step"]
+
+# Compositor overlay layers (firmware RGB_OVERLAY_LAYERS) and blend modes
+OVERLAY_LAYERS = 2
+LAYER_OFF = 0xFF
+BLEND_MODES = ["Add", "Screen", "Max", "Alpha"]
+
+# Input profiles (firmware profile_t): keymap window per GET_PROFILE, debounce modes
+PROFILE_KEYS_MAX = 16
+PROFILE_KEY_WINDOW = 3
+DEBOUNCE_MODES = ["eager", "deferred"]
+
+# Effect parameter slots and descriptor types (firmware src/rgb/effect_params.c)
+PARAM_NAMES = ["speed", "palette", "width", "decay"]
+PARAM_TYPES = ["none", "speed", "palette", "width", "decay"]
+PARAM_DEFAULT = 0xFF
+PALETTES = ["Rainbow", "Ocean", "Fire", "Plasma", "Viridis", "Sunset", "Arctic", "Earth", "Neon",
+            "Custom 1", "Custom 2", "Custom 3", "Custom 4"]  # Custom = uploaded slots 0..3
+PALETTE_UPLOAD_STATES = ["idle", "receiving", "stored", "rejected", "writing"]
+
+# Effect input flags reported by CMD_GET_EFFECT_INFO
+EFFECT_INPUT_ENCODER = 0x01
+EFFECT_INPUT_BUTTONS = 0x02
+EFFECT_INPUT_HID_RGB = 0x04
 
 
 def hid_enumerate_info():
@@ -124,7 +173,7 @@ def open_device():
 
 
 def get_status(dev):
-    """Return (effect_id, brightness) or (None, None) if not available."""
+    """Return (effect_id, brightness, transition_ms, current_limit_ma) or Nones if not available."""
     try:
         # Ask for feature data (report id prefix is required by hidapi)
         payload = bytes([REPORT_ID_CONFIG, 0x00] + [0] * 7)
@@ -132,12 +181,13 @@ def get_status(dev):
         dev.send_feature_report(payload)
         data = dev.get_feature_report(REPORT_ID_CONFIG, 9)  # id + 8 bytes
         log("get_feature_report ->", list(data) if data else None)
-        if data and len(data) >= 4:
-            # data[0] = report id, data[1]=status(0), data[2]=effect, data[3]=brightness
-            return data[2], data[3]
+        if data and len(data) >= 8:
+            # data[0] = report id, data[1]=status(0), data[2]=effect, data[3]=brightness,
+            # data[4..5]=transition ms (LE), data[6..7]=current limit mA (LE)
+            return data[2], data[3], data[4] | (data[5] << 8), data[6] | (data[7] << 8)
     except HIDErrors as e:
         log("get_status error:", e)
-    return None, None
+    return None, None, None, None
 
 
 def get_ext_status(dev):
@@ -167,6 +217,44 @@ def get_ext_status(dev):
     return {}
 
 
+def _query_effect_info(dev, effect_id: int, offset: int):
+    payload = bytes([REPORT_ID_CONFIG, CMD_GET_EFFECT_INFO,
+                    effect_id & 0xFF, offset & 0xFF] + [0] * 5)
+    dev.send_feature_report(payload)
+    data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+    log("effect info", effect_id, offset, "->", list(data) if data else None)
+    if not data or len(data) < 9 or data[1] != 0:
+        return None
+    # [id, status, count, inputs, name_len, c0..c3]
+    return data[2], data[3], data[4], bytes(data[5:9])
+
+
+def get_effects(dev):
+    """Enumerate effects from the firmware registry: list of (id, name, inputs)."""
+    effects = []
+    try:
+        first = _query_effect_info(dev, 0, 0)
+        if first is None:
+            return effects
+        count = first[0]
+        for eid in range(count):
+            info = first if eid == 0 else _query_effect_info(dev, eid, 0)
+            if info is None:
+                break
+            _, inputs, name_len, chunk = info
+            name = bytearray(chunk)
+            while len(name) < name_len:
+                more = _query_effect_info(dev, eid, len(name))
+                if more is None:
+                    break
+                name += more[3]
+            effects.append(
+                (eid, name[:name_len].decode("ascii", "replace"), inputs))
+    except HIDErrors as e:
+        log("get_effects error:", e)
+    return effects
+
+
 def set_effect(dev, effect_id: int):
     payload = [REPORT_ID_CONFIG, CMD_SET_EFFECT,
                int(effect_id) & 0xFF] + [0] * 6
@@ -181,6 +269,214 @@ def set_brightness(dev, value: int):
     dev.send_feature_report(bytes(payload))
 
 
+def set_transition(dev, ms: int):
+    v = max(0, min(2550, int(ms)))
+    payload = [REPORT_ID_CONFIG, CMD_SET_TRANSITION,
+               v & 0xFF, (v >> 8) & 0xFF] + [0] * 5
+    log("send_feature_report SET_TRANSITION:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def set_current_limit(dev, ma: int):
+    v = max(0, min(65535, int(ma)))
+    payload = [REPORT_ID_CONFIG, CMD_SET_CURRENT_LIMIT,
+               v & 0xFF, (v >> 8) & 0xFF] + [0] * 5
+    log("send_feature_report SET_CURRENT_LIMIT:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def get_layer(dev, layer: int):
+    """Return (effect_id, blend, opacity) for an overlay layer, or None."""
+    try:
+        payload = bytes([REPORT_ID_CONFIG, CMD_GET_LAYER, layer & 0xFF] + [0] * 6)
+        dev.send_feature_report(payload)
+        data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+        log("layer", layer, "->", list(data) if data else None)
+        if data and len(data) >= 6 and data[1] == 0:
+            # [id, status, layer, effect_id, blend, opacity]
+            return data[3], data[4], data[5]
+    except HIDErrors as e:
+        log("get_layer error:", e)
+    return None
+
+
+def set_layer(dev, layer: int, effect_id: int, blend: int, opacity: int):
+    payload = [REPORT_ID_CONFIG, CMD_SET_LAYER, layer & 0xFF, effect_id & 0xFF,
+               blend & 0xFF, max(0, min(255, int(opacity)))] + [0] * 3
+    log("send_feature_report SET_LAYER:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def get_flash_status(dev, reset_max: bool = False):
+    """Return flash write stats {pending, queued, last_us, max_us, commits}, or None."""
+    try:
+        payload = bytes([REPORT_ID_CONFIG, CMD_GET_FLASH_STATUS,
+                        1 if reset_max else 0] + [0] * 6)
+        dev.send_feature_report(payload)
+        data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+        log("flash status ->", list(data) if data else None)
+        if data and len(data) >= 9:
+            # [id, settings dirty | queued upload writes << 1, last(3 bytes le), max(3 bytes le), commits]
+            return {
+                "pending": bool(data[1] & 1),
+                "queued": data[1] >> 1,
+                "last_us": data[2] | (data[3] << 8) | (data[4] << 16),
+                "max_us": data[5] | (data[6] << 8) | (data[7] << 16),
+                "commits": data[8],
+            }
+    except HIDErrors as e:
+        log("get_flash_status error:", e)
+    return None
+
+
+def get_latency(dev, reset_max: bool = False):
+    """Return press-to-photon stats {last_us, avg_us, max_us, urgent_frames}, or None."""
+    try:
+        payload = bytes([REPORT_ID_CONFIG, CMD_GET_LATENCY,
+                        1 if reset_max else 0] + [0] * 6)
+        dev.send_feature_report(payload)
+        data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+        log("latency ->", list(data) if data else None)
+        if data and len(data) >= 9 and data[1] == 0:
+            # [id, status, last(lo,hi), avg(lo,hi), max(lo,hi), urgent]
+            return {
+                "last_us": data[2] | (data[3] << 8),
+                "avg_us": data[4] | (data[5] << 8),
+                "max_us": data[6] | (data[7] << 8),
+                "urgent_frames": data[8],
+            }
+    except HIDErrors as e:
+        log("get_latency error:", e)
+    return None
+
+
+def get_effect_params(dev, effect_id: int):
+    """Return the parameters an effect uses: {name: {type, min, max, default, value}}."""
+    params = {}
+    try:
+        for slot, name in enumerate(PARAM_NAMES):
+            dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_GET_EFFECT_PARAM,
+                                           effect_id & 0xFF, slot] + [0] * 5))
+            data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+            log("effect param", effect_id, slot, "->", list(data) if data else None)
+            if not data or len(data) < 8 or data[1] != 0:
+                return None
+            # [id, status, slot, type, min, max, default, value]
+            if data[3] and data[3] < len(PARAM_TYPES):
+                params[name] = {"type": PARAM_TYPES[data[3]], "min": data[4], "max": data[5],
+                                "default": data[6], "value": data[7]}
+    except HIDErrors as e:
+        log("get_effect_params error:", e)
+        return None
+    return params
+
+
+def set_effect_param(dev, effect_id: int, name: str, value=None):
+    """Set one effect parameter by name; value None restores the default. Stored on the device."""
+    v = PARAM_DEFAULT if value is None else max(0, min(254, int(value)))
+    payload = [REPORT_ID_CONFIG, CMD_SET_EFFECT_PARAM, effect_id & 0xFF,
+               PARAM_NAMES.index(name), v] + [0] * 4
+    log("send_feature_report SET_EFFECT_PARAM:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def upload_palette(dev, slot: int, stops):
+    """Store a custom palette: stops is a list of (pos 0..255, (r, g, b)); empty clears the slot."""
+    stops = sorted(stops, key=lambda st: st[0])
+    dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_PALETTE_BEGIN, slot & 0xFF, len(stops)] + [0] * 5))
+    for i, (pos, rgb) in enumerate(stops):
+        dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_PALETTE_STOP, i, pos & 0xFF,
+                                       rgb[0] & 0xFF, rgb[1] & 0xFF, rgb[2] & 0xFF] + [0] * 2))
+    dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_PALETTE_COMMIT] + [0] * 7))
+
+
+def get_palette_status(dev):
+    """Return {upload, valid_slots, slots, first_id, stops_max} for the custom palettes, or None."""
+    try:
+        dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_GET_PALETTE_STATUS] + [0] * 7))
+        data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+        log("palette status ->", list(data) if data else None)
+        if data and len(data) >= 6:
+            # [id, upload_state, valid_mask, slots, first_id, stops_max]
+            return {
+                "upload": PALETTE_UPLOAD_STATES[data[1]] if data[1] < len(PALETTE_UPLOAD_STATES) else data[1],
+                "valid_slots": [i for i in range(data[3]) if data[2] >> i & 1],
+                "slots": data[3],
+                "first_id": data[4],
+                "stops_max": data[5],
+            }
+    except HIDErrors as e:
+        log("get_palette_status error:", e)
+    return None
+
+
+def get_profile(dev):
+    """Return the active profile {active, count, enc_rev, debounce, debounce_us, keys}, or None."""
+    try:
+        prof = None
+        for off in range(0, PROFILE_KEYS_MAX, PROFILE_KEY_WINDOW):
+            dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_GET_PROFILE, off] + [0] * 6))
+            data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+            log("profile", off, "->", list(data) if data else None)
+            if not data or len(data) < 9:
+                return None
+            # [id, active, count, enc_rev, debounce, debounce_100us, key[off..off+2]]
+            if prof is None:
+                prof = {
+                    "active": data[1],
+                    "count": data[2],
+                    "enc_rev": data[3],
+                    "debounce": DEBOUNCE_MODES[data[4]] if data[4] < len(DEBOUNCE_MODES) else data[4],
+                    "debounce_us": data[5] * 100,
+                    "keys": [],
+                }
+            prof["keys"] += list(data[6:9])
+        prof["keys"] = prof["keys"][:PROFILE_KEYS_MAX]
+        return prof
+    except HIDErrors as e:
+        log("get_profile error:", e)
+    return None
+
+
+def set_profile(dev, index: int):
+    """Switch to a stored profile (keymap, encoders, debounce, effect)."""
+    payload = [REPORT_ID_CONFIG, CMD_SET_PROFILE, index & 0xFF] + [0] * 6
+    log("send_feature_report SET_PROFILE:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def set_profile_key(dev, button: int, keycode: int):
+    """Map a button to a HID keycode (0 = none) in the active profile."""
+    payload = [REPORT_ID_CONFIG, CMD_SET_PROFILE_KEY, button & 0xFF, keycode & 0xFF] + [0] * 5
+    log("send_feature_report SET_PROFILE_KEY:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def set_enc_rev(dev, mask: int):
+    """Set which encoders are reversed (bit per encoder) in the active profile."""
+    payload = [REPORT_ID_CONFIG, CMD_SET_ENC_REV, mask & 0xFF] + [0] * 6
+    log("send_feature_report SET_ENC_REV:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def set_sw_debounce(dev, mode: str, us: int):
+    """Set the switch debounce mode and time (100 us steps, up to 25.5 ms) in the active profile."""
+    t = max(0, min(255, int(us) // 100))
+    payload = [REPORT_ID_CONFIG, CMD_SET_SW_DEBOUNCE, DEBOUNCE_MODES.index(mode), t] + [0] * 5
+    log("send_feature_report SET_SW_DEBOUNCE:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
+def send_keyframe(dev, zone: int, rgb, ms: int, ease: str = "linear", delay_ms: int = 0):
+    """Fade a HID zone (or KEYFRAME_ALL_ZONES) to rgb over ms, starting after delay_ms."""
+    v = max(0, min(65535, int(ms)))
+    d = max(0, min(255, int(delay_ms) // 10))
+    payload = [REPORT_ID_CONFIG, CMD_HID_KEYFRAME, (zone & 0x0F) | (EASINGS.index(ease) << 4),
+               rgb[0] & 0xFF, rgb[1] & 0xFF, rgb[2] & 0xFF, v & 0xFF, (v >> 8) & 0xFF, d]
+    log("send_feature_report HID_KEYFRAME:", payload)
+    dev.send_feature_report(bytes(payload))
+
+
 def reboot_to_bootsel(dev):
     """Ask firmware to reboot into BOOTSEL (UF2) mode."""
     payload = [REPORT_ID_CONFIG, CMD_REBOOT_BOOTSEL] + [0] * 7
@@ -188,12 +484,115 @@ def reboot_to_bootsel(dev):
     dev.send_feature_report(bytes(payload))
 
 
+_tlv_txn = 0
+
+
+def tlv_transaction(dev, items):
+    """Run [(op, key, data)] as one transaction; return [(status, key, data)] or None if unsupported."""
+    global _tlv_txn
+    _tlv_txn = (_tlv_txn + 1) & 0xFF
+    req = [TLV_VERSION, _tlv_txn]
+    for op, key, data in items:
+        req += [op, key, len(data)] + [b & 0xFF for b in data]
+    if len(req) > TLV_REPORT_SIZE:
+        raise ValueError(f"transaction too large ({len(req)} > {TLV_REPORT_SIZE} bytes)")
+    try:
+        dev.send_feature_report(bytes([REPORT_ID_TLV] + req + [TLV_OP_END] * (TLV_REPORT_SIZE - len(req))))
+        data = dev.get_feature_report(REPORT_ID_TLV, TLV_REPORT_SIZE + 1)
+    except HIDErrors as e:
+        log("tlv_transaction error:", e)  # Firmware without REPORT_ID_TLV
+        return None
+    log("tlv", list(req[:16]), "->", list(data[:16]) if data else None)
+    # [id, version, txn, status, count, items [status, key, len, data]...]
+    if not data or len(data) < 5 or data[1] != TLV_VERSION or data[2] != _tlv_txn:
+        return None
+    out, at = [], 5
+    for _ in range(data[4]):
+        st, key, n = data[at], data[at + 1], data[at + 2]
+        out.append((st, key, bytes(data[at + 3:at + 3 + n])))
+        at += 3 + n
+    return out
+
+
+def get_all_settings(dev):
+    """Read every setting in one round trip: dict keyed like apply_config(), or None.
+
+    Custom palettes are not settings and are not included.
+    """
+    items = tlv_transaction(dev, [(TLV_OP_GET, TLV_KEYS["settings"], [])])
+    if not items:
+        return None
+    cfg = {"layers": {}, "effect_params": {}}
+    for st, key, d in items:
+        if st != 0:
+            continue
+        name = TLV_KEY_NAMES.get(key)
+        if name == "device":
+            cfg["device"] = dict(zip(["version", "buttons", "encoders", "effects", "layers",
+                                      "profiles", "params", "palettes"], d))
+        elif name == "layer":
+            cfg["layers"][d[0]] = {"effect": d[1], "blend": d[2], "opacity": d[3]}
+        elif name == "effect_param":
+            cfg["effect_params"][d[0]] = {PARAM_NAMES[i]: v for i, v in enumerate(d[1:])
+                                          if i < len(PARAM_NAMES) and v != PARAM_DEFAULT}
+        elif name == "keymap":
+            cfg["keymap"] = list(d)
+        elif name == "sw_debounce":
+            cfg["sw_debounce"] = {"mode": DEBOUNCE_MODES[d[0]] if d[0] < len(DEBOUNCE_MODES) else d[0],
+                                  "us": d[1] * 100}
+        elif name in ("transition", "current_limit", "enc_ppr"):
+            cfg[name] = d[0] | (d[1] << 8)
+        elif name:
+            cfg[name] = d[0]
+    return cfg
+
+
+def apply_config(dev, cfg):
+    """Apply a settings dict (same keys as get_all_settings()) as one transaction, saved once.
+
+    "profile" is switched first so the per-profile settings land in it. Returns
+    a list of (key name, error) for rejected items, or None if the firmware has
+    no TLV support.
+    """
+    items = []
+
+    def u16(v):
+        return [v & 0xFF, (v >> 8) & 0xFF]
+    if "profile" in cfg:
+        items.append((TLV_OP_SET, TLV_KEYS["profile"], [cfg["profile"]]))
+    for name in ("effect", "brightness", "mouse_sens", "enc_debounce", "enc_rev"):
+        if name in cfg:
+            items.append((TLV_OP_SET, TLV_KEYS[name], [int(cfg[name])]))
+    for name in ("transition", "current_limit", "enc_ppr"):
+        if name in cfg:
+            items.append((TLV_OP_SET, TLV_KEYS[name], u16(int(cfg[name]))))
+    if "keymap" in cfg:
+        items.append((TLV_OP_SET, TLV_KEYS["keymap"], cfg["keymap"]))
+    if "sw_debounce" in cfg:
+        db = cfg["sw_debounce"]
+        items.append((TLV_OP_SET, TLV_KEYS["sw_debounce"],
+                      [DEBOUNCE_MODES.index(db["mode"]), max(0, min(255, int(db["us"]) // 100))]))
+    for layer, lc in cfg.get("layers", {}).items():
+        items.append((TLV_OP_SET, TLV_KEYS["layer"],
+                      [int(layer), lc["effect"], lc["blend"], max(0, min(255, int(lc["opacity"])))]))
+    # One block per effect; parameters left out go back to their default
+    for eid, params in cfg.get("effect_params", {}).items():
+        block = [PARAM_DEFAULT if params.get(n) is None else int(params[n]) for n in PARAM_NAMES]
+        items.append((TLV_OP_SET, TLV_KEYS["effect_param"], [int(eid)] + block))
+    reply = tlv_transaction(dev, items)
+    if reply is None:
+        return None
+    return [(TLV_KEY_NAMES.get(key, key), TLV_STATUS[st] if st < len(TLV_STATUS) else st)
+            for st, key, _ in reply if st != 0]
+
+
 class App(tk.Tk):
     def __init__(self):
         super().__init__()
         self.title("Pico IIDX Config Tool")
-        self.geometry("520x360")
+        self.geometry("520x500")
         self.dev = None
+        self.effects = []
 
         frm = ttk.Frame(self, padding=10)
         frm.pack(fill=tk.BOTH, expand=True)
@@ -203,7 +602,7 @@ class App(tk.Tk):
         self.combo = ttk.Combobox(
             frm,
             textvariable=self.effect_var,
-            values=[name for _, name in EFFECTS],
+            values=[],
             state="readonly",
         )
         self.combo.grid(row=0, column=1, sticky="ew", padx=(8, 0))
@@ -226,9 +625,47 @@ class App(tk.Tk):
         self.brightness_scale.grid(
             row=1, column=1, sticky="ew", padx=(8, 0), pady=(8, 0))
 
+        ttk.Label(frm, text="Transition (ms):").grid(
+            row=2, column=0, sticky="w", pady=(10, 0))
+        self.transition_var = tk.IntVar(value=500)
+        self.transition_entry = ttk.Entry(
+            frm, textvariable=self.transition_var, width=8)
+        self.transition_entry.grid(
+            row=2, column=1, sticky="w", padx=(8, 0), pady=(8, 0))
+        # Strip current budget next to the transition entry (0 = unlimited)
+        limfrm = ttk.Frame(frm)
+        limfrm.grid(row=2, column=1, sticky="e", pady=(8, 0))
+        ttk.Label(limfrm, text="Current limit (mA):").grid(
+            row=0, column=0, sticky="e")
+        self.limit_var = tk.IntVar(value=400)
+        self.limit_entry = ttk.Entry(
+            limfrm, textvariable=self.limit_var, width=8)
+        self.limit_entry.grid(row=0, column=1, sticky="w", padx=(8, 0))
+
+        # Compositor overlays drawn over the base effect
+        ovlfrm = ttk.LabelFrame(frm, text="Overlays", padding=8)
+        ovlfrm.grid(row=3, column=0, columnspan=3, sticky="ew", pady=(12, 0))
+        ovlfrm.columnconfigure(1, weight=1)
+        self.overlays = []
+        for i in range(OVERLAY_LAYERS):
+            ttk.Label(ovlfrm, text=f"Layer {i + 1}:").grid(
+                row=i, column=0, sticky="w")
+            eff = ttk.Combobox(ovlfrm, values=["None"], state="readonly")
+            eff.current(0)
+            eff.grid(row=i, column=1, sticky="ew", padx=(8, 0))
+            blend = ttk.Combobox(ovlfrm, values=BLEND_MODES,
+                                 state="readonly", width=7)
+            blend.current(1)
+            blend.grid(row=i, column=2, padx=(8, 0))
+            opacity = ttk.Scale(ovlfrm, from_=0, to=255,
+                                orient=tk.HORIZONTAL, length=90)
+            opacity.set(255)
+            opacity.grid(row=i, column=3, padx=(8, 0))
+            self.overlays.append((eff, blend, opacity))
+
     # Encoder/Mouse settings frame
         encfrm = ttk.LabelFrame(frm, text="Encoder & Mouse", padding=8)
-        encfrm.grid(row=2, column=0, columnspan=3, sticky="ew", pady=(12, 0))
+        encfrm.grid(row=4, column=0, columnspan=3, sticky="ew", pady=(12, 0))
         encfrm.columnconfigure(1, weight=1)
         ttk.Label(encfrm, text="Encoder PPR:").grid(
             row=0, column=0, sticky="w")
@@ -251,7 +688,7 @@ class App(tk.Tk):
 
         ledfrm = ttk.LabelFrame(
             frm, text="WS2812B (applied on reboot)", padding=8)
-        ledfrm.grid(row=3, column=0, columnspan=3, sticky="ew", pady=(12, 0))
+        ledfrm.grid(row=5, column=0, columnspan=3, sticky="ew", pady=(12, 0))
         ttk.Label(ledfrm, text="LED Count:").grid(row=0, column=0, sticky="w")
         self.led_count_var = tk.IntVar(value=10)
         self.led_count_entry = ttk.Entry(
@@ -268,12 +705,12 @@ class App(tk.Tk):
         # Status (above bottom buttons)
         self.status_var = tk.StringVar(value="Not connected")
         ttk.Label(frm, textvariable=self.status_var).grid(
-            row=4, column=0, columnspan=3, sticky="w", pady=(12, 0)
+            row=6, column=0, columnspan=3, sticky="w", pady=(12, 0)
         )
 
         # Bottom buttons row (at the end)
         btnfrm = ttk.Frame(frm, padding=(0, 0, 0, 0))
-        btnfrm.grid(row=5, column=0, columnspan=3, sticky="ew")
+        btnfrm.grid(row=7, column=0, columnspan=3, sticky="ew")
         btnfrm.columnconfigure(1, weight=1)
         self.btn_refresh = ttk.Button(
             btnfrm, text="Refresh", command=self.refresh)
@@ -309,39 +746,100 @@ class App(tk.Tk):
         if not self.dev:
             messagebox.showwarning("Device", "Not connected")
             return
-        eff, bri = get_status(self.dev)
-        if eff is not None and 0 <= eff < len(EFFECTS):
-            self.combo.current(eff)
+        # Effect list comes from the firmware registry, so it never drifts
+        effects = get_effects(self.dev)
+        if effects:
+            self.effects = effects
+            self.combo.configure(values=[name for _, name, _ in effects])
+            for eff, _, _ in self.overlays:
+                eff.configure(values=["None"] + [name for _, name, _ in effects])
+        cfg = get_all_settings(self.dev)
+        if cfg:
+            eff, bri = cfg.get("effect"), cfg.get("brightness")
+            trans, limit = cfg.get("transition"), cfg.get("current_limit")
         else:
+            eff, bri, trans, limit = get_status(self.dev)
+        if eff is not None and 0 <= eff < len(self.effects):
+            self.combo.current(eff)
+        elif self.effects:
             self.combo.current(0)
         if bri is not None:
             self.brightness_scale.set(bri)
             self.brightness_val_label.configure(text=str(int(bri)))
+        if trans is not None:
+            self.transition_var.set(trans)
+        if limit is not None:
+            self.limit_var.set(limit)
+        for i, (eff, blend, opacity) in enumerate(self.overlays):
+            if cfg:
+                lc = cfg["layers"].get(i + 1)
+                layer = (lc["effect"], lc["blend"], lc["opacity"]) if lc else None
+            else:
+                layer = get_layer(self.dev, i + 1)
+            if layer is None:
+                continue
+            eid, mode, op = layer
+            eff.current(eid + 1 if eid < len(self.effects) else 0)
+            if mode < len(BLEND_MODES):
+                blend.current(mode)
+            opacity.set(op)
         # Extended settings
-        ext = get_ext_status(self.dev)
+        ext = cfg if cfg else get_ext_status(self.dev)
         if ext:
             self.ppr_var.set(ext.get("enc_ppr", self.ppr_var.get()))
             self.mouse_var.set(ext.get("mouse_sens", self.mouse_var.get()))
             self.db_var.set(1 if ext.get("enc_debounce") else 0)
-            self.led_count_var.set(
-                ext.get("ws_led_size", self.led_count_var.get()))
-            self.zones_var.set(ext.get("ws_led_zones", self.zones_var.get()))
+            if "ws_led_size" in ext:
+                self.led_count_var.set(ext["ws_led_size"])
+                self.zones_var.set(ext["ws_led_zones"])
+        lat = get_latency(self.dev)
+        if lat:
+            self.status_var.set(
+                f"Connected — press-to-photon {lat['last_us']} µs "
+                f"(avg {lat['avg_us']}, max {lat['max_us']})")
 
     def apply(self):
         if not self.dev:
             messagebox.showwarning("Device", "Not connected")
             return
         idx = self.combo.current()
+        if idx < 0:
+            messagebox.showwarning("Effect", "No effect selected")
+            return
         try:
-            set_effect(self.dev, idx)
             bri = int(float(self.brightness_scale.get()))
+            ppr = max(1, min(4000, int(self.ppr_var.get())))
+            ms = max(1, min(50, int(self.mouse_var.get())))
+            layers = {}
+            for i, (eff, blend, opacity) in enumerate(self.overlays):
+                sel = eff.current()
+                layers[i + 1] = {"effect": sel - 1 if sel > 0 else LAYER_OFF,
+                                 "blend": max(0, blend.current()), "opacity": int(float(opacity.get()))}
+            errors = apply_config(self.dev, {
+                "effect": idx, "brightness": bri, "transition": self.transition_var.get(),
+                "current_limit": self.limit_var.get(), "layers": layers, "enc_ppr": ppr,
+                "mouse_sens": ms, "enc_debounce": 1 if self.db_var.get() else 0,
+            })
+            if errors is not None:
+                # One transaction, one flash save
+                self.status_var.set(
+                    f"Applied: {self.effects[idx][1]}, Brightness {bri} (PPR {ppr}, Sens {ms})"
+                    + (f" — rejected {errors}" if errors else ""))
+                return
+            # Older firmware: one 8-byte command per setting
+            set_effect(self.dev, idx)
             set_brightness(self.dev, bri)
+            set_transition(self.dev, self.transition_var.get())
+            set_current_limit(self.dev, self.limit_var.get())
+            for i, (eff, blend, opacity) in enumerate(self.overlays):
+                sel = eff.current()
+                eid = sel - 1 if sel > 0 else LAYER_OFF
+                set_layer(self.dev, i + 1, eid, max(0, blend.current()),
+                          int(float(opacity.get())))
             # Apply encoder/mouse immediate settings
-            ppr = max(1, min(4000, int(self.ppr_var.get())))
             devh = self.dev
             devh.send_feature_report(bytes(
                 [REPORT_ID_CONFIG, CMD_SET_ENCODER_PPR, ppr & 0xFF, (ppr >> 8) & 0xFF, 0, 0, 0, 0, 0]))
-            ms = max(1, min(50, int(self.mouse_var.get())))
             devh.send_feature_report(
                 bytes([REPORT_ID_CONFIG, CMD_SET_MOUSE_SENS, ms, 0, 0, 0, 0, 0, 0]))
             # Persist debounce and WS params (take effect after reboot)
@@ -353,7 +851,7 @@ class App(tk.Tk):
             devh.send_feature_report(bytes(
                 [REPORT_ID_CONFIG, CMD_SET_WS_PARAMS, count & 0xFF, (count >> 8) & 0xFF, zones, 0, 0, 0, 0]))
             self.status_var.set(
-                f"Applied: {EFFECTS[idx][1]}, Brightness {bri} (PPR {ppr}, Sens {ms})")
+                f"Applied: {self.effects[idx][1]}, Brightness {bri} (PPR {ppr}, Sens {ms})")
         except HIDErrors as e:
             log("apply error:", e)
             messagebox.showerror("Error", str(e))
@@ -392,6 +890,182 @@ if __name__ == "__main__":
             log("cli reboot error:", e)
             print(f"ERR: {e}")
             sys.exit(1)
+    # Headless CLI: --dump [FILE.json] reads every setting in one transaction
+    if "--dump" in sys.argv:
+        try:
+            device = open_device()
+            cfg = get_all_settings(device)
+            if cfg is None:
+                print("ERR: firmware has no TLV config support")
+                sys.exit(1)
+            args = sys.argv[sys.argv.index("--dump") + 1:]
+            text = json.dumps(cfg, indent=2)
+            if args and not args[0].startswith("--"):
+                with open(args[0], "w") as f:
+                    f.write(text + "\n")
+            else:
+                print(text)
+            sys.exit(0)
+        except HIDErrors as e:
+            log("cli dump error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: --apply FILE.json writes a --dump'ed (or hand-written subset) config in one transaction
+    if "--apply" in sys.argv:
+        try:
+            with open(sys.argv[sys.argv.index("--apply") + 1]) as f:
+                cfg = json.load(f)
+            cfg.pop("device", None)
+            cfg["layers"] = {int(k): v for k, v in cfg.get("layers", {}).items()}
+            device = open_device()
+            errors = apply_config(device, cfg)
+            if errors is None:
+                print("ERR: firmware has no TLV config support")
+                sys.exit(1)
+            for name, err in errors:
+                print(f"ERR: {name}: {err}")
+            if not errors:
+                print("OK: config applied")
+            sys.exit(1 if errors else 0)
+        except (IndexError, OSError, ValueError) as e:
+            print(f"usage: --apply FILE.json ({e})")
+            sys.exit(2)
+        except HIDErrors as e:
+            log("cli apply error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: print press-to-photon telemetry
+    if "--latency" in sys.argv:
+        try:
+            device = open_device()
+            lat = get_latency(device, reset_max="--reset" in sys.argv)
+            if lat is None:
+                print("ERR: no latency data")
+                sys.exit(1)
+            print("last {last_us} us, avg {avg_us} us, max {max_us} us, "
+                  "urgent frames {urgent_frames}".format(**lat))
+            sys.exit(0)
+        except HIDErrors as e:
+            log("cli latency error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: print flash write stall telemetry
+    if "--flash" in sys.argv:
+        try:
+            device = open_device()
+            st = get_flash_status(device, reset_max="--reset" in sys.argv)
+            if st is None:
+                print("ERR: no flash status")
+                sys.exit(1)
+            print("last stall {last_us} us, max stall {max_us} us, settings commits {commits}, "
+                  "pending {pending}, queued upload writes {queued}".format(**st))
+            sys.exit(0)
+        except HIDErrors as e:
+            log("cli flash status error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: --params EFFECT_ID [NAME VALUE|default]
+    if "--params" in sys.argv:
+        try:
+            args = sys.argv[sys.argv.index("--params") + 1:]
+            eid = int(args[0])
+            device = open_device()
+            if len(args) > 2:
+                set_effect_param(device, eid, args[1], None if args[2] == "default" else
+                                 PALETTES.index(args[2]) if args[2] in PALETTES else int(args[2]))
+            params = get_effect_params(device, eid)
+            if params is None:
+                print("ERR: unknown effect")
+                sys.exit(1)
+            for name, p in params.items():
+                shown = PALETTES[p["value"]] if p["type"] == "palette" and p["value"] < len(PALETTES) else p["value"]
+                print(f"{name}: {shown} ({p['type']} {p['min']}..{p['max']}, default {p['default']})")
+            sys.exit(0)
+        except (IndexError, ValueError):
+            print("usage: --params EFFECT_ID [" + "|".join(PARAM_NAMES) + " VALUE|default]")
+            sys.exit(2)
+        except HIDErrors as e:
+            log("cli params error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: --palette SLOT POS:RRGGBB ... | --palette SLOT clear
+    if "--palette" in sys.argv:
+        try:
+            args = sys.argv[sys.argv.index("--palette") + 1:]
+            slot = int(args[0])
+            stops = []
+            if args[1] != "clear":
+                for a in args[1:]:
+                    if a.startswith("--"):
+                        break
+                    pos, hexc = a.split(":")
+                    c = int(hexc, 16)
+                    stops.append((int(pos), (c >> 16 & 0xFF, c >> 8 & 0xFF, c & 0xFF)))
+            device = open_device()
+            upload_palette(device, slot, stops)
+            st = get_palette_status(device)
+            deadline = time.monotonic() + 2
+            while st and st["upload"] == "writing" and time.monotonic() < deadline:
+                time.sleep(0.02)  # The device writes flash from its main loop
+                st = get_palette_status(device)
+            print(st if st else "ERR: no status")
+            sys.exit(0 if st and st["upload"] == "stored" else 1)
+        except (IndexError, ValueError):
+            print("usage: --palette SLOT POS:RRGGBB [POS:RRGGBB ...] | --palette SLOT clear")
+            sys.exit(2)
+        except HIDErrors as e:
+            log("cli palette error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: --profile [N] [key BUTTON KEYCODE | enc-rev MASK | debounce MODE US]
+    if "--profile" in sys.argv:
+        try:
+            args = sys.argv[sys.argv.index("--profile") + 1:]
+            device = open_device()
+            if args and args[0].isdigit():
+                set_profile(device, int(args[0]))
+                args = args[1:]
+            if args and args[0] == "key":
+                set_profile_key(device, int(args[1]), int(args[2], 0))
+            elif args and args[0] == "enc-rev":
+                set_enc_rev(device, int(args[1], 0))
+            elif args and args[0] == "debounce":
+                set_sw_debounce(device, args[1], int(args[2]))
+            prof = get_profile(device)
+            if prof is None:
+                print("ERR: no profile data")
+                sys.exit(1)
+            print("profile {active}/{count}: enc_rev {enc_rev:#x}, debounce {debounce} {debounce_us} us".format(**prof))
+            print("keys:", " ".join(f"{k:#04x}" for k in prof["keys"]))
+            sys.exit(0)
+        except (IndexError, ValueError):
+            print("usage: --profile [N] [key BUTTON KEYCODE | enc-rev MASK | debounce "
+                  + "|".join(DEBOUNCE_MODES) + " US]")
+            sys.exit(2)
+        except HIDErrors as e:
+            log("cli profile error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
+    # Headless CLI: --keyframe ZONE|all RRGGBB MS [EASE] [DELAY_MS]
+    if "--keyframe" in sys.argv:
+        try:
+            args = sys.argv[sys.argv.index("--keyframe") + 1:]
+            zone = KEYFRAME_ALL_ZONES if args[0] == "all" else int(args[0])
+            c = int(args[1], 16)
+            ease = args[3] if len(args) > 3 else "linear"
+            delay = int(args[4]) if len(args) > 4 else 0
+            device = open_device()
+            send_keyframe(device, zone, (c >> 16 & 0xFF, c >> 8 & 0xFF, c & 0xFF),
+                          int(args[2]), ease, delay)
+            print("OK: keyframe sent")
+            sys.exit(0)
+        except (IndexError, ValueError):
+            print("usage: --keyframe ZONE|all RRGGBB MS [" + "|".join(EASINGS) + "] [DELAY_MS]")
+            sys.exit(2)
+        except HIDErrors as e:
+            log("cli keyframe error:", e)
+            print(f"ERR: {e}")
+            sys.exit(1)
     # Default: launch GUI
     app = App()
     app.mainloop()
@@ -0,0 +1,177 @@
+#!/usr/bin/env python3
+"""
+Reference host streamer for the firmware's "Host Stream" effect (src/rgb/host_stream.c).
+
+  python tools/led_stream.py [--fps 200] [--leds 40] [--seconds N]   stream a demo animation
+  python tools/led_stream.py --stdin [--leds 40]                     stream raw RGB frames from stdin
+  python tools/led_stream.py --status                                received/dropped frame counts
+
+--stdin reads leds*3 bytes per frame (r, g, b per LED in strip order) and
+sends each as soon as it is read, so another program can pipe frames in;
+without --stdin the demo is paced at --fps. The streamer selects the
+"Host Stream" effect first.
+
+Each frame is sent as delta tokens against the previous one
+(src/rgb/delta_codec.c), split over as few stream reports as possible, and
+unchanged frames are not sent at all. A keyframe goes out every second, and at once if the device
+reports it lost sync, so a dropped packet heals quickly.
+"""
+import colorsys
+import math
+import sys
+import time
+
+from clip_pack import encode_tokens
+from effect_selector import (REPORT_ID_CONFIG, HIDErrors, get_effects, open_device,
+                             set_effect, get_status)
+
+REPORT_ID_STREAM = 6
+REPORT_SIZE = 63                # STREAM_REPORT_SIZE
+PAYLOAD = REPORT_SIZE - 3       # [seq, flags, len] header
+FLAG_KEY = 0x01
+FLAG_END = 0x02
+CMD_GET_STREAM_STATUS = 0x31
+KEYFRAME_INTERVAL_S = 1.0
+
+
+def packets(seq, tokens, key):
+    """Split a frame's tokens into stream reports (tokens never straddle two)."""
+    chunks, cur = [], b""
+    for t in tokens:
+        # Literals are split to fill the current report; other tokens are 1 or 4 bytes
+        while t[0] >> 6 == 2 and len(cur) + len(t) > PAYLOAD and PAYLOAD - len(cur) >= 4:
+            n = (PAYLOAD - len(cur) - 1) // 3
+            cur += bytes([0x80 | (n - 1)]) + t[1:1 + 3 * n]
+            t = bytes([t[0] - n]) + t[1 + 3 * n:]
+            chunks.append(cur)
+            cur = b""
+        if len(cur) + len(t) > PAYLOAD:
+            chunks.append(cur)
+            cur = b""
+        cur += t
+    chunks.append(cur)
+    if len(chunks) > 64:
+        raise ValueError("frame needs more than 64 packets")
+    out = []
+    for i, c in enumerate(chunks):
+        flags = i << 2 | (FLAG_KEY if key else 0) | (FLAG_END if i == len(chunks) - 1 else 0)
+        out.append(bytes([REPORT_ID_STREAM, seq & 0xFF, flags, len(c)]) + c + bytes(PAYLOAD - len(c)))
+    return out
+
+
+def stream_status(dev):
+    dev.send_feature_report(bytes([REPORT_ID_CONFIG, CMD_GET_STREAM_STATUS] + [0] * 7))
+    data = dev.get_feature_report(REPORT_ID_CONFIG, 9)
+    if not data or len(data) < 7:
+        return None
+    # [id, status, frames(lo,hi), dropped(lo,hi), need_key]
+    return {"frames": data[2] | data[3] << 8, "dropped": data[4] | data[5] << 8,
+            "need_key": bool(data[6])}
+
+
+def select_stream_effect(dev):
+    for eid, name, _ in get_effects(dev):
+        if name == "Host Stream":
+            if get_status(dev)[0] != eid:
+                set_effect(dev, eid)
+            return True
+    return False
+
+
+def demo(leds, t):
+    """Two counter-rotating hue bands over a slow breathing floor."""
+    frame = []
+    floor = 0.04 + 0.03 * math.sin(t * 1.3)
+    for i in range(leds):
+        a = (i / leds + t * 0.25) % 1.0
+        b = (i / leds - t * 0.4) % 1.0
+        v = max(floor, 1.0 - min(a, 1 - a) * 8, 1.0 - min(b, 1 - b) * 12)
+        r, g, bl = colorsys.hsv_to_rgb((t * 0.05 + i / leds) % 1.0, 1.0, min(v, 1.0))
+        frame.append((int(r * 255), int(g * 255), int(bl * 255)))
+    return frame
+
+
+def frames_from_stdin(leds):
+    size = leds * 3
+    while True:
+        raw = sys.stdin.buffer.read(size)
+        if len(raw) < size:
+            return
+        yield [tuple(raw[i:i + 3]) for i in range(0, size, 3)]
+
+
+def run(dev, source, fps, leds, paced):
+    period = 1.0 / fps
+    prev = None
+    seq = 0
+    sent_frames = sent_bytes = 0
+    last_key = last_report = start = time.monotonic()
+    next_t = start
+    for frame in source:
+        now = time.monotonic()
+        key = prev is None or now - last_key >= KEYFRAME_INTERVAL_S
+        if now - last_report >= 1.0:
+            st = stream_status(dev)
+            key = key or (st is not None and st["need_key"])
+            print(f"{sent_frames / (now - last_report):.0f} fps, {sent_bytes / (now - last_report) / 1024:.1f} KB/s"
+                  + (f", device dropped {st['dropped']}" if st else ""))
+            sent_frames = sent_bytes = 0
+            last_report = now
+        if key or frame != prev:
+            tokens = encode_tokens([(0, 0, 0)] * leds if key else prev, frame)
+            for p in packets(seq, tokens, key):
+                dev.write(p)
+                sent_bytes += len(p)
+            seq += 1
+            sent_frames += 1
+            prev = frame
+            if key:
+                last_key = now
+        if paced:
+            next_t += period
+            delay = next_t - time.monotonic()
+            if delay > 0:
+                time.sleep(delay)
+            else:
+                next_t = time.monotonic()  # Overran: resync instead of bursting
+
+
+def _opt(argv, flag, default):
+    return argv[argv.index(flag) + 1] if flag in argv else default
+
+
+def main(argv):
+    if "-h" in argv or "--help" in argv:
+        print(__doc__)
+        return 0
+    fps = float(_opt(argv, "--fps", 200))
+    leds = int(_opt(argv, "--leds", 40))
+    seconds = float(_opt(argv, "--seconds", 0))
+    try:
+        dev = open_device()
+        if "--status" in argv:
+            st = stream_status(dev)
+            print(st if st else "ERR: no status")
+            return 0 if st else 1
+        if not select_stream_effect(dev):
+            print("ERR: firmware has no Host Stream effect")
+            return 1
+        if "--stdin" in argv:
+            run(dev, frames_from_stdin(leds), fps, leds, paced=False)
+        else:
+            t0 = time.monotonic()
+
+            def source():
+                while not seconds or time.monotonic() - t0 < seconds:
+                    yield demo(leds, time.monotonic() - t0)
+            run(dev, source(), fps, leds, paced=True)
+        return 0
+    except KeyboardInterrupt:
+        return 0
+    except (OSError, HIDErrors, ValueError) as e:
+        print(f"ERR: {e}")
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -0,0 +1,240 @@
+#!/usr/bin/env python3
+"""
+Assembler and uploader for the firmware's bytecode effect (src/rgb/vm_core.c).
+
+  python tools/rgbvm.py asm prog.rvs [-o prog.rvm]   assemble to an image
+  python tools/rgbvm.py upload prog.rvs|prog.rvm     assemble if needed, store on the device
+  python tools/rgbvm.py status                       upload state and last frame cost
+
+Then select the "Bytecode" effect. To time a program on the host:
+
+  cc -O2 -o rgb_vm_bench tools/bench/rgb_vm_bench.c && ./rgb_vm_bench prog.rvm
+
+Source format, one instruction per line, ';' starts a comment:
+
+  .name "Plasma"      program name (15 chars max)
+  .frame              following code runs once per frame (default)
+  .pixel              following code runs once per LED
+  label:              jump target (within the same section)
+
+  ldi   rD, 1.5       load a number (Q16.16; 1 or 2 instructions)
+  ldc   rD, 0xRRGGBB  load a color
+  mov/abs/frac/floor/sin/pal/hid  rD, rA
+  add/sub/mul/div/min/max/slt/btst/rgb/cscale/cadd/clerp  rD, rA, rB
+  in    rD, <input>   see INPUTS
+  ldg   rD, n / stg rS, n     global slot n (0..15), kept across frames
+  ldp   rD / stp rS           this LED's state word, kept across frames
+  rand  rD / out rS / halt
+  jmp label / jz rS, label / jnz rS, label
+"""
+import struct
+import sys
+import time
+import zlib
+
+MAGIC = 0x314D5652  # 'RVM1'
+IMAGE_MAX = 4096    # One flash sector (RGB_VM_FLASH_SIZE)
+HEADER = struct.Struct("<IHHI16s")
+ONE = 0x10000
+
+OPS = {
+    "halt": 0x00, "ldi": 0x01, "ldhi": 0x02, "mov": 0x03, "add": 0x04, "sub": 0x05,
+    "mul": 0x06, "div": 0x07, "min": 0x08, "max": 0x09, "abs": 0x0A, "frac": 0x0B,
+    "floor": 0x0C, "slt": 0x0D, "sin": 0x0E, "rand": 0x0F, "in": 0x10, "btst": 0x11,
+    "ldg": 0x12, "stg": 0x13, "ldp": 0x14, "stp": 0x15,
+    "pal": 0x20, "hid": 0x21, "rgb": 0x22, "cscale": 0x23, "cadd": 0x24, "clerp": 0x25,
+    "out": 0x26, "jmp": 0x30, "jz": 0x31, "jnz": 0x32,
+}
+# Operand shapes: d = dest reg, a/b = source regs, i = imm16, l = label
+SHAPES = {
+    "halt": "", "mov": "da", "abs": "da", "frac": "da", "floor": "da", "sin": "da",
+    "pal": "da", "hid": "da", "add": "dab", "sub": "dab", "mul": "dab", "div": "dab",
+    "min": "dab", "max": "dab", "slt": "dab", "btst": "dab", "rgb": "dab",
+    "cscale": "dab", "cadd": "dab", "clerp": "dab", "rand": "d", "ldp": "d",
+    "stp": "d", "out": "d", "ldg": "di", "stg": "di", "in": "di",
+    "jmp": "l", "jz": "dl", "jnz": "dl",
+}
+# "hid" is 1.0 once the host's lights have timed out, 0 while the host drives them
+INPUTS = ["time", "dt", "enc0", "enc1", "denc0", "denc1", "buttons", "pressed", "hid",
+          "overlay", "leds", "led", "ring", "x", "y", "zone", "button", "held"]
+
+
+class AsmError(Exception):
+    pass
+
+
+def _reg(tok):
+    if not (tok.startswith("r") and tok[1:].isdigit() and int(tok[1:]) < 16):
+        raise AsmError(f"bad register '{tok}'")
+    return int(tok[1:])
+
+
+def _word(op, d=0, a=0, b=0, imm=None):
+    if imm is not None:
+        return OPS[op] | d << 8 | (imm & 0xFFFF) << 16
+    return OPS[op] | d << 8 | a << 16 | b << 24
+
+
+def assemble(text):
+    """Return the image bytes for a program source."""
+    name = b""
+    sections = {"frame": [], "pixel": []}
+    labels = {}
+    cur = "frame"
+    # Pass 1: expand pseudo-ops into (op, args) and record labels
+    for lineno, raw in enumerate(text.splitlines(), 1):
+        line = raw.split(";", 1)[0].strip()
+        if not line:
+            continue
+        try:
+            if line.startswith(".name"):
+                name = line.split(None, 1)[1].strip().strip('"').encode()[:15]
+                continue
+            if line in (".frame", ".pixel"):
+                cur = line[1:]
+                continue
+            if line.endswith(":"):
+                labels[line[:-1]] = (cur, len(sections[cur]))
+                continue
+            mnem, _, rest = line.partition(" ")
+            mnem = mnem.lower()
+            args = [t.strip() for t in rest.split(",")] if rest.strip() else []
+            if mnem in ("ldi", "ldc"):
+                d = _reg(args[0])
+                if mnem == "ldi":
+                    v = int(round(float(args[1]) * ONE))
+                else:
+                    c = int(args[1], 0)
+                    v = (c >> 16 & 0xFF) | (c & 0xFF00) | (c & 0xFF) << 16  # RGB_t: r in the low byte
+                v &= 0xFFFFFFFF
+                lo = v & 0xFFFF
+                sections[cur].append(("ldi", d, lo, lineno))
+                if (lo | (0xFFFF0000 if lo & 0x8000 else 0)) != v:
+                    sections[cur].append(("ldhi", d, v >> 16, lineno))
+                continue
+            if mnem not in SHAPES:
+                raise AsmError(f"unknown instruction '{mnem}'")
+            if len(args) != len(SHAPES[mnem]):
+                raise AsmError(f"'{mnem}' takes {len(SHAPES[mnem])} operands")
+            sections[cur].append((mnem, args, lineno))
+        except (AsmError, ValueError, IndexError) as e:
+            raise AsmError(f"line {lineno}: {e}") from None
+
+    # Pass 2: encode
+    words = {}
+    for sec, items in sections.items():
+        out = []
+        for pc, item in enumerate(items):
+            lineno = item[-1]
+            try:
+                if item[0] in ("ldi", "ldhi"):
+                    out.append(_word(item[0], item[1], imm=item[2]))
+                    continue
+                mnem, args, _ = item
+                d = a = b = 0
+                imm = None
+                for shape, tok in zip(SHAPES[mnem], args):
+                    if shape == "d":
+                        d = _reg(tok)
+                    elif shape == "a":
+                        a = _reg(tok)
+                    elif shape == "b":
+                        b = _reg(tok)
+                    elif shape == "i":
+                        imm = INPUTS.index(tok) if mnem == "in" and tok in INPUTS else int(tok, 0)
+                    elif shape == "l":
+                        if tok not in labels or labels[tok][0] != sec:
+                            raise AsmError(f"unknown label '{tok}' in .{sec}")
+                        imm = labels[tok][1] - (pc + 1)
+                out.append(_word(mnem, d, a, b, imm))
+            except (AsmError, ValueError) as e:
+                raise AsmError(f"line {lineno}: {e}") from None
+        words[sec] = out
+
+    code = words["frame"] + words["pixel"]
+    body = struct.pack(f"<{len(code)}I", *code)
+    image = HEADER.pack(MAGIC, len(code), len(words["frame"]),
+                        zlib.crc32(body) & 0xFFFFFFFF, name) + body
+    if len(image) > IMAGE_MAX:
+        raise AsmError(f"program is {len(image)} bytes, limit {IMAGE_MAX}")
+    return image
+
+
+def load_image(path):
+    if path.endswith(".rvm"):
+        with open(path, "rb") as f:
+            return f.read()
+    with open(path, encoding="utf-8") as f:
+        return assemble(f.read())
+
+
+# ---- Device side (config feature report, see README) ----
+
+CMD_VM_BEGIN = 0x40
+CMD_VM_DATA = 0x41
+CMD_VM_COMMIT = 0x42
+CMD_GET_VM_STATUS = 0x43
+UPLOAD_STATES = ["idle", "receiving", "stored", "rejected", "writing"]
+RESULTS = ["ok", "over budget", "fault"]
+
+
+def upload(dev, image, report_id):
+    dev.send_feature_report(bytes([report_id, CMD_VM_BEGIN] + [0] * 7))
+    for off in range(0, len(image), 5):
+        chunk = list(image[off:off + 5])
+        dev.send_feature_report(bytes([report_id, CMD_VM_DATA, off & 0xFF, off >> 8]
+                                      + chunk + [0] * (5 - len(chunk))))
+    dev.send_feature_report(bytes([report_id, CMD_VM_COMMIT] + [0] * 7))
+
+
+def status(dev, report_id):
+    dev.send_feature_report(bytes([report_id, CMD_GET_VM_STATUS] + [0] * 7))
+    data = dev.get_feature_report(report_id, 9)
+    if not data or len(data) < 8:
+        return None
+    # [id, upload_state, valid, words(lo,hi), insns(lo,hi), result]
+    return {
+        "upload": UPLOAD_STATES[data[1]] if data[1] < len(UPLOAD_STATES) else data[1],
+        "valid": bool(data[2]),
+        "words": data[3] | data[4] << 8,
+        "insns_per_frame": data[5] | data[6] << 8,
+        "result": RESULTS[data[7]] if data[7] < len(RESULTS) else data[7],
+    }
+
+
+def main(argv):
+    if len(argv) < 2 or argv[1] not in ("asm", "upload", "status"):
+        print(__doc__)
+        return 2
+    try:
+        if argv[1] == "asm":
+            image = load_image(argv[2])
+            out = argv[argv.index("-o") + 1] if "-o" in argv else argv[2].rsplit(".", 1)[0] + ".rvm"
+            with open(out, "wb") as f:
+                f.write(image)
+            print(f"{out}: {len(image)} bytes, {(len(image) - HEADER.size) // 4} instructions")
+            return 0
+    except (AsmError, OSError) as e:
+        print(f"ERR: {e}")
+        return 1
+
+    from effect_selector import REPORT_ID_CONFIG, HIDErrors, open_device
+    try:
+        dev = open_device()
+        if argv[1] == "upload":
+            image = load_image(argv[2])
+            upload(dev, image, REPORT_ID_CONFIG)
+        st = status(dev, REPORT_ID_CONFIG)
+        deadline = time.monotonic() + 2
+        while st and st["upload"] == "writing" and time.monotonic() < deadline:
+            time.sleep(0.02)  # The device writes flash from its main loop
+            st = status(dev, REPORT_ID_CONFIG)
+        print(st if st else "ERR: no status")
+        return 0 if st and st["upload"] != "rejected" else 1
+    except (AsmError, OSError, HIDErrors) as e:
+        print(f"ERR: {e}")
+        return 1
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))